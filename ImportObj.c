@@ -1,62 +1,156 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
 #include "ImportObj.h"
 #include "calcs.h"  // Include your calcs header
 
-#define MAX_VERTS 50000
-#define MAX_TRIS  100000
+// Initial array sizes, both grow as needed
+#define INITIAL_VERTS 4096
+#define INITIAL_TRIS  8192
+
+// Reads the next vertex index of a face, skipping any /vt/vn suffix.
+// Used instead of strtok so several threads can load models at once.
+static int NextFaceIndex(char** cursor) {
+    char* end;
+    long value = strtol(*cursor, &end, 10);
+    if (end == *cursor) return 0;
+
+    while (*end && *end != ' ' && *end != '\t' && *end != '\r' && *end != '\n') end++;
+    *cursor = end;
+    return (int)value;
+}
+
+bool ParseObjVertex(const char* line, Vec3* out) {
+    if (line[0] != 'v' || line[1] != ' ') return false;
+
+    Vec3 v = {0, 0, 0};
+    sscanf(line, "v %f %f %f", &v.x, &v.y, &v.z);
+    // Invert Y axis here
+    v.y = -v.y;
+
+    *out = v;
+    return true;
+}
+
+bool ParseObjFace(const char* line, int* i0, int* i1, int* i2) {
+    if (line[0] != 'f' || line[1] != ' ') return false;
+
+    char* cursor = (char*)line + 2;
+    *i0 = NextFaceIndex(&cursor);
+    *i1 = NextFaceIndex(&cursor);
+    *i2 = NextFaceIndex(&cursor);
+    return true;
+}
+
+Triangle MakeObjTriangle(Vec3 p0, Vec3 p1, Vec3 p2) {
+    // Swap the last two vertices to invert winding (flip normals)
+    Triangle tri = {
+        .v0.pos = p0,
+        .v1.pos = p2,  // swapped
+        .v2.pos = p1,  // swapped
+    };
+    return tri;
+}
+
+// Doubles an array's capacity, returning NULL (with the array untouched) when
+// it can't grow. Counts are handed back as int, so INT_MAX elements is the cap
+// and the byte size is checked before it can wrap.
+static void* GrowArray(void* array, size_t* capacity, size_t element_size) {
+    if (*capacity >= INT_MAX) return NULL;
+
+    size_t grown = *capacity > INT_MAX / 2 ? INT_MAX : *capacity * 2;
+    if (grown > SIZE_MAX / element_size) return NULL;
+
+    void* resized = realloc(array, grown * element_size);
+    if (resized) *capacity = grown;
+    return resized;
+}
 
 Triangle* LoadObjTriangles(const char* filename, int* out_count) {
+    *out_count = 0;
+
     FILE* file = fopen(filename, "r");
     if (!file) {
         fprintf(stderr, "Failed to open OBJ file: %s\n", filename);
-        *out_count = 0;
         return NULL;
     }
 
-    Vec3* verts = malloc(sizeof(Vec3) * MAX_VERTS);
+    size_t vert_capacity = INITIAL_VERTS;
+    Vec3* verts = malloc(sizeof(Vec3) * vert_capacity);
     int vert_count = 0;
 
-    Triangle* tris = malloc(sizeof(Triangle) * MAX_TRIS);
+    size_t tri_capacity = INITIAL_TRIS;
+    Triangle* tris = malloc(sizeof(Triangle) * tri_capacity);
     int tri_count = 0;
 
+    if (!verts || !tris) {
+        fprintf(stderr, "Failed to allocate OBJ buffers\n");
+        free(verts);
+        free(tris);
+        fclose(file);
+        return NULL;
+    }
+
+    bool outOfMemory = false;
+    int skipped_faces = 0;
     char line[512];
     while (fgets(line, sizeof(line), file)) {
-        if (line[0] == 'v' && line[1] == ' ') {
-            Vec3 v;
-            sscanf(line, "v %f %f %f", &v.x, &v.y, &v.z);
-            // Invert Y axis here
-            v.y = -v.y;
-
-            if (vert_count < MAX_VERTS) {
-                verts[vert_count++] = v;
+        Vec3 v;
+        int i0 = 0, i1 = 0, i2 = 0;
+
+        if (ParseObjVertex(line, &v)) {
+            if ((size_t)vert_count == vert_capacity) {
+                Vec3* grown = GrowArray(verts, &vert_capacity, sizeof(Vec3));
+                if (!grown) {
+                    outOfMemory = true;
+                    break;
+                }
+                verts = grown;
             }
-        } else if (line[0] == 'f' && line[1] == ' ') {
-            int i0 = 0, i1 = 0, i2 = 0;
-
-            char* token = strtok(line + 2, " \n");
-            if (token) i0 = atoi(token);
-            token = strtok(NULL, " \n");
-            if (token) i1 = atoi(token);
-            token = strtok(NULL, " \n");
-            if (token) i2 = atoi(token);
-
-            if (i0 > 0 && i1 > 0 && i2 > 0 && tri_count < MAX_TRIS) {
-                // Swap i1 and i2 to invert winding (flip normals)
-                Triangle tri = {
-                    .v0.pos = verts[i0 - 1],
-                    .v1.pos = verts[i2 - 1],  // swapped
-                    .v2.pos = verts[i1 - 1],  // swapped
-                };
-                tris[tri_count++] = tri;
+            verts[vert_count++] = v;
+        } else if (ParseObjFace(line, &i0, &i1, &i2)) {
+            if (i0 <= 0 || i1 <= 0 || i2 <= 0 || i0 > vert_count || i1 > vert_count || i2 > vert_count) {
+                skipped_faces++;
+                continue;
             }
+
+            if ((size_t)tri_count == tri_capacity) {
+                Triangle* grown = GrowArray(tris, &tri_capacity, sizeof(Triangle));
+                if (!grown) {
+                    outOfMemory = true;
+                    break;
+                }
+                tris = grown;
+            }
+            tris[tri_count++] = MakeObjTriangle(verts[i0 - 1], verts[i1 - 1], verts[i2 - 1]);
         }
     }
 
+    // Running out of memory or a read error mid-file is reported rather than silently truncating
+    bool readError = ferror(file);
     fclose(file);
     free(verts);
 
+    if (outOfMemory) {
+        fprintf(stderr, "Could not grow buffers loading %s after %d triangles; "
+                "use the paged mode (-c/-s) for scenes this large\n", filename, tri_count);
+        free(tris);
+        return NULL;
+    }
+    if (readError) {
+        fprintf(stderr, "Failed to read OBJ file %s after %d triangles\n", filename, tri_count);
+        free(tris);
+        return NULL;
+    }
+
+    // Same message as the paged builder, which skips the same faces
+    if (skipped_faces > 0) {
+        fprintf(stderr, "Skipped %d faces with missing or out of range vertex indices in %s\n",
+                skipped_faces, filename);
+    }
+
     *out_count = tri_count;
     return tris;
-}
\ No newline at end of file
+}
@@ -1,6 +1,7 @@
 #ifndef IMPORT_OBJ_H
 #define IMPORT_OBJ_H
 
+#include <stdbool.h>
 #include "calcs.h"
 
 // Load triangles from an .obj file.
@@ -8,4 +9,10 @@
 // Caller must free the returned array.
 Triangle* LoadObjTriangles(const char* filename, int* out_count);
 
+// Line level helpers shared with the paged (out-of-core) builder so both
+// paths apply the same axis flip and winding.
+bool ParseObjVertex(const char* line, Vec3* out);
+bool ParseObjFace(const char* line, int* i0, int* i1, int* i2);
+Triangle MakeObjTriangle(Vec3 p0, Vec3 p1, Vec3 p2);
+
 #endif
@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+#define ARENA_ALIGNMENT 16
+
+// ===== Arena =====
+
+bool arena_init(Arena *arena, size_t capacity) {
+    arena->base = capacity > 0 ? malloc(capacity) : NULL;
+    arena->capacity = arena->base ? capacity : 0;
+    arena->offset = 0;
+    arena->highWater = 0;
+
+    if (capacity > 0 && !arena->base) {
+        fprintf(stderr, "Failed to reserve %zu bytes for arena\n", capacity);
+        return false;
+    }
+    return true;
+}
+
+void arena_destroy(Arena *arena) {
+    free(arena->base);
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->offset = 0;
+}
+
+void arena_reset(Arena *arena) {
+    arena->offset = 0;
+}
+
+void* arena_alloc(Arena *arena, size_t size) {
+    size_t start = (arena->offset + (ARENA_ALIGNMENT - 1)) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (start > arena->capacity || size > arena->capacity - start) {
+        fprintf(stderr, "Arena exhausted: requested %zu bytes, %zu of %zu in use\n",
+                size, arena->offset, arena->capacity);
+        return NULL;
+    }
+
+    arena->offset = start + size;
+    if (arena->offset > arena->highWater) arena->highWater = arena->offset;
+
+    return arena->base + start;
+}
+
+void* arena_calloc(Arena *arena, size_t count, size_t size) {
+    if (size != 0 && count > (size_t)-1 / size) return NULL;
+
+    void *mem = arena_alloc(arena, count * size);
+    if (mem) memset(mem, 0, count * size);
+    return mem;
+}
+
+char* arena_strdup(Arena *arena, const char *str) {
+    size_t len = strlen(str) + 1;
+    char *copy = arena_alloc(arena, len);
+    if (copy) memcpy(copy, str, len);
+    return copy;
+}
@@ -0,0 +1,27 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// ==== Linear (bump) arena ====
+// Memory is reserved once up front; allocations just bump an offset and are
+// all released together by arena_reset(). Used for per-frame transient data.
+
+typedef struct {
+    unsigned char *base;
+    size_t capacity;
+    size_t offset;
+    size_t highWater; // Largest offset ever reached, useful for sizing
+} Arena;
+
+bool arena_init(Arena *arena, size_t capacity);
+void arena_destroy(Arena *arena);
+void arena_reset(Arena *arena);
+
+// Returns 16 byte aligned memory, or NULL if the arena is exhausted
+void* arena_alloc(Arena *arena, size_t size);
+void* arena_calloc(Arena *arena, size_t count, size_t size);
+char* arena_strdup(Arena *arena, const char *str);
+
+#endif
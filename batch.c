@@ -0,0 +1,369 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <SDL3/SDL.h>
+
+#include "raster.h"
+#include "calcs.h"
+#include "ImportObj.h"
+#include "meshlet.h"
+#include "imageIO.h"
+
+// Offline batch renderer: renders every asset in a list from a set of camera
+// poses into PPM files, spreading assets across worker threads. No window is
+// opened; SDL is only used for threads and timing.
+//
+// Usage: CRasterizerBatch -o out_dir [-l list.txt] [-p poses.txt | -t turntable_frames]
+//            [-w width] [-h height] [-j threads] [obj ...]
+
+#define BATCH_MAX_POSES 4096
+
+typedef struct {
+    char **assets;
+    int assetCount;
+    Camera *poses;          // Fixed poses, used when turntableFrames is 0
+    int poseCount;
+    int turntableFrames;    // Orbit frames framed around each asset's bounds
+    const char *outDir;
+    int width, height;
+    SDL_AtomicInt nextAsset;
+    SDL_AtomicInt failures;
+    SDL_AtomicInt framesWritten;
+} BatchJob;
+
+// One rasterizer context per worker, reused for every asset it picks up
+typedef struct {
+    BatchJob *job;
+    int index;
+    uint32_t *pixelBuffer;
+    float *zbuffer;
+} BatchWorker;
+
+// Deterministic per-triangle colour so re-runs produce identical images
+static Vec4 BatchTriangleColour(int index) {
+    uint32_t h = (uint32_t)(index + 1) * 2654435761u;
+    h ^= h >> 15;
+    return (Vec4){
+        (float)((h >> 0) & 0xFF) / 255.0f,
+        (float)((h >> 8) & 0xFF) / 255.0f,
+        (float)((h >> 16) & 0xFF) / 255.0f,
+        1.0f
+    };
+}
+
+// Turntable camera orbiting the bounding sphere slightly from above, looking at its
+// centre. The loader flips Y, so "above" the model is the negative Y side here.
+#define TURNTABLE_ELEVATION 0.35f
+
+static Camera TurntablePose(Vec3 center, float radius, int frame, int frameCount) {
+    float angle = 2.0f * 3.14159265f * (float)frame / (float)frameCount;
+    float distance = radius * 2.5f;
+    Vec3 offset = {
+        sinf(angle) * cosf(TURNTABLE_ELEVATION),
+        -sinf(TURNTABLE_ELEVATION),
+        cosf(angle) * cosf(TURNTABLE_ELEVATION)
+    };
+
+    // The view looks down -forward, so forward points from the centre to the camera
+    Camera cam = {
+        .position = vec3_add(center, vec3_scale(offset, distance)),
+        .yaw = angle,
+        .pitch = -TURNTABLE_ELEVATION
+    };
+    return cam;
+}
+
+static void MeshBounds(const Triangle *tris, int count, Vec3 *center, float *radius) {
+    Vec3 minP = tris[0].v0.pos, maxP = tris[0].v0.pos;
+    for (int i = 0; i < count; i++) {
+        const Vec3 corners[3] = { tris[i].v0.pos, tris[i].v1.pos, tris[i].v2.pos };
+        for (int k = 0; k < 3; k++) {
+            minP.x = fminf(minP.x, corners[k].x); maxP.x = fmaxf(maxP.x, corners[k].x);
+            minP.y = fminf(minP.y, corners[k].y); maxP.y = fmaxf(maxP.y, corners[k].y);
+            minP.z = fminf(minP.z, corners[k].z); maxP.z = fmaxf(maxP.z, corners[k].z);
+        }
+    }
+    *center = vec3_scale(vec3_add(minP, maxP), 0.5f);
+    *radius = fmaxf(vec3_length(vec3_sub(maxP, minP)) * 0.5f, 1e-3f);
+}
+
+// Output file stem: asset file name without directory or extension
+static void AssetStem(const char *path, char *stem, size_t size) {
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    snprintf(stem, size, "%s", name);
+    char *dot = strrchr(stem, '.');
+    if (dot && dot != stem) *dot = '\0';
+}
+
+static bool RenderAsset(BatchWorker *worker, const char *path) {
+    BatchJob *job = worker->job;
+
+    int triangleCount = 0;
+    Triangle *tris = LoadObjTriangles(path, &triangleCount);
+    if (!tris || triangleCount == 0) {
+        fprintf(stderr, "[worker %d] failed to load %s\n", worker->index, path);
+        free(tris);
+        return false;
+    }
+
+    // Sized by the asset like the triangles, which the loader no longer caps
+    MeshCullData cull;
+    Vec4 *colours = malloc(sizeof(Vec4) * triangleCount);
+    if (!colours || !BuildMeshCullData(tris, triangleCount, &cull)) {
+        fprintf(stderr, "[worker %d] out of memory preparing %s (%d triangles)\n", worker->index, path,
+                triangleCount);
+        free(colours);
+        free(tris);
+        return false;
+    }
+    for (int i = 0; i < triangleCount; i++) colours[i] = BatchTriangleColour(i);
+
+    Vec3 center;
+    float radius;
+    MeshBounds(tris, triangleCount, &center, &radius);
+
+    char stem[256];
+    AssetStem(path, stem, sizeof(stem));
+
+    Mat4 model = mat4_identity();
+    Mat4 proj = mat4_perspective(70.0f * (3.14159f / 180.0f), (float)job->width / job->height, 0.1f, 100.0f);
+    int frameCount = job->turntableFrames > 0 ? job->turntableFrames : job->poseCount;
+
+    bool ok = true;
+    for (int f = 0; f < frameCount; f++) {
+        Camera cam = job->turntableFrames > 0
+            ? TurntablePose(center, radius, f, job->turntableFrames)
+            : job->poses[f];
+
+        Vec3 target = vec3_add(cam.position, get_camera_forward(cam));
+        Mat4 view = mat4_look_at(cam.position, target, (Vec3){0, 1, 0});
+        Mat4 mvp = mat4_mul(proj, mat4_mul(view, model));
+
+        RasterizeScene(job->height, job->width, worker->zbuffer, model, tris, cam.position, mvp,
+                colours, &cull, worker->pixelBuffer, job->width, NULL, NULL);
+
+        char outPath[1024];
+        snprintf(outPath, sizeof(outPath), "%s/%s_%04d.ppm", job->outDir, stem, f);
+        if (WritePPM(outPath, worker->pixelBuffer, job->width, job->height, job->width)) {
+            SDL_AddAtomicInt(&job->framesWritten, 1);
+        } else {
+            ok = false;
+        }
+    }
+
+    FreeMeshCullData(&cull);
+    free(colours);
+    free(tris);
+    return ok;
+}
+
+static int SDLCALL BatchWorkerThread(void *data) {
+    BatchWorker *worker = data;
+    BatchJob *job = worker->job;
+
+    for (;;) {
+        int asset = SDL_AddAtomicInt(&job->nextAsset, 1); // Returns the previous value
+        if (asset >= job->assetCount) break;
+
+        if (!RenderAsset(worker, job->assets[asset])) {
+            SDL_AddAtomicInt(&job->failures, 1);
+        }
+    }
+
+    return 0;
+}
+
+// Appends non-empty, non-comment lines of a text file to a growing array
+static bool ReadAssetList(const char *path, char ***assets, int *count, int *capacity) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Failed to open asset list: %s\n", path);
+        return false;
+    }
+
+    char line[1024];
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+
+        if (*count == *capacity) {
+            int newCapacity = *capacity ? *capacity * 2 : 64;
+            char **grown = realloc(*assets, sizeof(char *) * newCapacity);
+            if (!grown) {
+                fclose(file);
+                return false;
+            }
+            *assets = grown;
+            *capacity = newCapacity;
+        }
+        char *asset = strdup(line);
+        if (!asset) {
+            fprintf(stderr, "Failed to allocate asset path: %s\n", line);
+            fclose(file);
+            return false;
+        }
+        (*assets)[(*count)++] = asset;
+    }
+
+    fclose(file);
+    return true;
+}
+
+// Pose file: one "x y z yaw pitch" camera per line. Poses past maxPoses are
+// dropped with a warning.
+static int ReadPoses(const char *path, Camera *poses, int maxPoses) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Failed to open pose file: %s\n", path);
+        return -1;
+    }
+
+    int count = 0;
+    int dropped = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        Camera cam;
+        if (sscanf(line, "%f %f %f %f %f", &cam.position.x, &cam.position.y, &cam.position.z,
+                &cam.yaw, &cam.pitch) != 5) continue;
+
+        if (count < maxPoses) {
+            poses[count++] = cam;
+        } else {
+            dropped++;
+        }
+    }
+
+    fclose(file);
+    if (dropped > 0) {
+        fprintf(stderr, "Pose file %s has more than %d poses, dropped the last %d\n", path, maxPoses, dropped);
+    }
+    return count;
+}
+
+int main(int argc, char* argv[]) {
+    BatchJob job = {0};
+    job.width = 256;
+    job.height = 256;
+
+    const char *listPath = NULL;
+    const char *posePath = NULL;
+    int threadCount = SDL_GetNumLogicalCPUCores();
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:l:p:t:w:h:j:")) != -1) {
+        switch (opt) {
+            case 'o': job.outDir = optarg; break;
+            case 'l': listPath = optarg; break;
+            case 'p': posePath = optarg; break;
+            case 't': job.turntableFrames = atoi(optarg); break;
+            case 'w': job.width = atoi(optarg); break;
+            case 'h': job.height = atoi(optarg); break;
+            case 'j': threadCount = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s -o out_dir [-l list.txt] [-p poses.txt | -t turntable_frames] "
+                        "[-w width] [-h height] [-j threads] [obj ...]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (!job.outDir || job.width <= 0 || job.height <= 0) {
+        fprintf(stderr, "An output directory and a positive resolution are required\n");
+        return 1;
+    }
+
+    // Assets come from the list file and/or the remaining arguments
+    int assetCapacity = 0;
+    if (listPath && !ReadAssetList(listPath, &job.assets, &job.assetCount, &assetCapacity)) return 1;
+    for (int i = optind; i < argc; i++) {
+        if (job.assetCount == assetCapacity) {
+            assetCapacity = assetCapacity ? assetCapacity * 2 : 64;
+            char **grown = realloc(job.assets, sizeof(char *) * assetCapacity);
+            if (!grown) return 1;
+            job.assets = grown;
+        }
+        char *asset = strdup(argv[i]);
+        if (!asset) {
+            fprintf(stderr, "Failed to allocate asset path: %s\n", argv[i]);
+            return 1;
+        }
+        job.assets[job.assetCount++] = asset;
+    }
+
+    if (job.assetCount == 0) {
+        fprintf(stderr, "No assets to render\n");
+        return 1;
+    }
+
+    // Same default camera as the interactive viewer
+    Camera *poses = malloc(sizeof(Camera) * BATCH_MAX_POSES);
+    if (!poses) return 1;
+    job.poses = poses;
+    if (posePath) {
+        job.poseCount = ReadPoses(posePath, poses, BATCH_MAX_POSES);
+        if (job.poseCount <= 0) {
+            fprintf(stderr, "No camera poses read from %s\n", posePath);
+            return 1;
+        }
+    } else {
+        poses[0] = (Camera){ .position = {0, 0, 2}, .yaw = 0.0f, .pitch = 0.0f };
+        job.poseCount = 1;
+    }
+
+    if (threadCount < 1) threadCount = 1;
+    if (threadCount > job.assetCount) threadCount = job.assetCount;
+
+    BatchWorker *workers = calloc(threadCount, sizeof(BatchWorker));
+    SDL_Thread **threads = calloc(threadCount, sizeof(SDL_Thread *));
+    if (!workers || !threads) return 1;
+
+    for (int i = 0; i < threadCount; i++) {
+        workers[i].job = &job;
+        workers[i].index = i;
+        workers[i].pixelBuffer = malloc(sizeof(uint32_t) * job.width * job.height);
+        workers[i].zbuffer = malloc(sizeof(float) * job.width * job.height);
+        if (!workers[i].pixelBuffer || !workers[i].zbuffer) {
+            fprintf(stderr, "Failed to allocate framebuffers for worker %d\n", i);
+            return 1;
+        }
+    }
+
+    printf("Rendering %d assets x %d frames at %dx%d on %d threads\n", job.assetCount,
+            job.turntableFrames > 0 ? job.turntableFrames : job.poseCount, job.width, job.height, threadCount);
+
+    uint64_t start = SDL_GetPerformanceCounter();
+
+    // Worker 0 runs on this thread
+    for (int i = 1; i < threadCount; i++) {
+        threads[i] = SDL_CreateThread(BatchWorkerThread, "BatchWorker", &workers[i]);
+        if (!threads[i]) fprintf(stderr, "Failed to start worker %d: %s\n", i, SDL_GetError());
+    }
+    BatchWorkerThread(&workers[0]);
+    for (int i = 1; i < threadCount; i++) {
+        if (threads[i]) SDL_WaitThread(threads[i], NULL);
+    }
+
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+    int failures = SDL_GetAtomicInt(&job.failures);
+    int frames = SDL_GetAtomicInt(&job.framesWritten);
+
+    printf("Done: %d assets (%d failed), %d frames in %.2f s -> %.2f assets/s, %.2f frames/s\n",
+            job.assetCount, failures, frames, seconds,
+            seconds > 0.0 ? job.assetCount / seconds : 0.0,
+            seconds > 0.0 ? frames / seconds : 0.0);
+
+    for (int i = 0; i < threadCount; i++) {
+        free(workers[i].pixelBuffer);
+        free(workers[i].zbuffer);
+    }
+    for (int i = 0; i < job.assetCount; i++) free(job.assets[i]);
+    free(job.assets);
+    free(workers);
+    free(threads);
+    free(poses);
+
+    return failures == 0 ? 0 : 1;
+}
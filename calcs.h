@@ -55,8 +55,10 @@ Mat4 mat4_translation(Vec3 t);
 Mat4 mat4_scale(Vec3 s);
 Mat4 mat4_rotation_y(float angle_rad);
 Mat4 mat4_perspective(float fov_y_rad, float aspect, float near_z, float far_z);
+Mat4 mat4_orthographic(float left, float right, float bottom, float top, float near_z, float far_z);
 Mat4 mat4_look_at(Vec3 eye, Vec3 center, Vec3 up);
 Vec3 mat4_mul_vec3(const Mat4 mat, Vec3 v);
+Mat4 mat4_inverse(Mat4 m);
 
 // ==== Geometry types ====
 typedef struct {
@@ -3,15 +3,20 @@
 #include "eventMgr.h"
 #include "calcs.h"
 
-void HandleEvents(bool *running, Camera *cam, float rotSpeed, float moveSpeed, 
+bool HandleEvents(bool *running, Camera *cam, float rotSpeed, float moveSpeed, 
         float PITCH_LIMIT, float deltaTime, float MOUSE_SENSITIVITY) {
     // We define our event here for simplicity
     SDL_Event event;
+    Camera before = *cam;
+    bool windowDirty = false;
 
     while (SDL_PollEvent(&event)) {
         if (event.type == SDL_EVENT_QUIT) {
             *running = false;
         }
+        if (event.type == SDL_EVENT_WINDOW_EXPOSED || event.type == SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED) {
+            windowDirty = true;
+        }
         if (event.type == SDL_EVENT_KEY_DOWN) {
             if (event.key.key == SDLK_ESCAPE) {
                 *running = false;
@@ -57,4 +62,7 @@ void HandleEvents(bool *running, Camera *cam, float rotSpeed, float moveSpeed,
     
     cam->yaw += mouse_delta_x * MOUSE_SENSITIVITY;
     cam->pitch -= mouse_delta_y * MOUSE_SENSITIVITY;
+
+    return windowDirty || cam->position.x != before.position.x || cam->position.y != before.position.y ||
+        cam->position.z != before.position.z || cam->yaw != before.yaw || cam->pitch != before.pitch;
 }
@@ -3,7 +3,9 @@
 #ifndef EVENTMGR_H
 #define EVENTMGR_H
 
-void HandleEvents(bool *running, Camera *cam, float rotSpeed, float moveSpeed, float PITCH_LIMIT, 
+// Returns true when the view needs redrawing: the camera moved or turned,
+// or the window was exposed or resized
+bool HandleEvents(bool *running, Camera *cam, float rotSpeed, float moveSpeed, float PITCH_LIMIT, 
         float deltaTime, float MOUSE_SENSITIVITY);
 
 #endif
@@ -0,0 +1,32 @@
+#include <SDL3/SDL.h>
+
+#include "framePacer.h"
+
+// Sleeps can overshoot by about a scheduler tick, so stop sleeping this far
+// before the deadline and spin the rest
+#define SPIN_NS (2 * 1000000ull)
+
+void FramePacerInit(FramePacer *pacer, int targetFps) {
+    pacer->frameNS = targetFps > 0 ? 1000000000ull / (uint64_t)targetFps : 0;
+    pacer->deadlineNS = SDL_GetTicksNS() + pacer->frameNS;
+}
+
+void FramePacerWait(FramePacer *pacer) {
+    if (pacer->frameNS == 0) return;
+
+    uint64_t now = SDL_GetTicksNS();
+    if (now >= pacer->deadlineNS) {
+        // Missed the slot, don't try to make the time up with a burst of frames
+        pacer->deadlineNS = now + pacer->frameNS;
+        return;
+    }
+
+    if (pacer->deadlineNS - now > SPIN_NS) {
+        SDL_DelayNS(pacer->deadlineNS - now - SPIN_NS);
+    }
+    while (SDL_GetTicksNS() < pacer->deadlineNS) {
+        // Spin out the remainder
+    }
+
+    pacer->deadlineNS += pacer->frameNS;
+}
@@ -0,0 +1,23 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <stdint.h>
+
+// ==== Frame pacing ====
+// Holds the loop to a target frame rate. Most of the wait is an OS sleep so
+// the CPU is free; only the last SPIN stretch busy-waits, which absorbs the
+// scheduler's wake-up jitter so frames land on time.
+
+typedef struct {
+    uint64_t frameNS;     // Frame interval, 0 when uncapped
+    uint64_t deadlineNS;  // When the next frame may start
+} FramePacer;
+
+// targetFps <= 0 disables pacing
+void FramePacerInit(FramePacer *pacer, int targetFps);
+
+// Blocks until the next frame slot. A frame that overran starts the next
+// interval from now instead of rushing to catch up.
+void FramePacerWait(FramePacer *pacer);
+
+#endif
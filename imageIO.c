@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "imageIO.h"
+
+bool WritePPM(const char *path, const uint32_t *pixels, int width, int height, int pitch) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return false;
+    }
+
+    unsigned char *row = malloc((size_t)width * 3);
+    if (!row) {
+        fclose(file);
+        return false;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    for (int y = 0; y < height; y++) {
+        const uint32_t *src = pixels + (size_t)y * pitch;
+        for (int x = 0; x < width; x++) {
+            row[x * 3 + 0] = (unsigned char)(src[x] >> 16); // Red
+            row[x * 3 + 1] = (unsigned char)(src[x] >> 8);  // Green
+            row[x * 3 + 2] = (unsigned char)(src[x] >> 0);  // Blue
+        }
+        fwrite(row, 3, width, file);
+    }
+
+    free(row);
+    return fclose(file) == 0;
+}
+
+bool WritePFM(const char *path, const float *values, int width, int height) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return false;
+    }
+
+    // Negative scale marks little-endian data; PFM rows run bottom to top
+    fprintf(file, "Pf\n%d %d\n-1.0\n", width, height);
+    for (int y = height - 1; y >= 0; y--) {
+        fwrite(values + (size_t)y * width, sizeof(float), width, file);
+    }
+
+    return fclose(file) == 0;
+}
+
+// Reads "<magic>\n<w> <h>\n<extra>\n" headers shared by PPM and PFM
+// extra must hold at least 32 bytes
+static FILE* OpenNetpbm(const char *path, const char *magic, int *width, int *height, char *extra) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    char tag[3] = {0};
+    if (fscanf(file, "%2s %d %d %31s", tag, width, height, extra) != 4
+        || strcmp(tag, magic) != 0 || *width <= 0 || *height <= 0) {
+        fprintf(stderr, "Unsupported image header in %s\n", path);
+        fclose(file);
+        return NULL;
+    }
+
+    fgetc(file); // Single whitespace byte before the binary data
+    return file;
+}
+
+uint32_t* LoadPPM(const char *path, int *out_width, int *out_height) {
+    char maxval[32];
+    FILE *file = OpenNetpbm(path, "P6", out_width, out_height, maxval);
+    if (!file) return NULL;
+
+    if (strcmp(maxval, "255") != 0) {
+        fprintf(stderr, "Only 8 bit PPM files are supported: %s\n", path);
+        fclose(file);
+        return NULL;
+    }
+
+    size_t count = (size_t)*out_width * *out_height;
+    uint32_t *pixels = malloc(sizeof(uint32_t) * count);
+    unsigned char *rgb = malloc(count * 3);
+    if (!pixels || !rgb || fread(rgb, 3, count, file) != count) {
+        fprintf(stderr, "Failed to read pixel data from %s\n", path);
+        free(pixels);
+        free(rgb);
+        fclose(file);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        pixels[i] = 0xFF000000u | ((uint32_t)rgb[i * 3] << 16) | ((uint32_t)rgb[i * 3 + 1] << 8) | rgb[i * 3 + 2];
+    }
+
+    free(rgb);
+    fclose(file);
+    return pixels;
+}
+
+float* LoadPFM(const char *path, int *out_width, int *out_height) {
+    char scale[32];
+    FILE *file = OpenNetpbm(path, "Pf", out_width, out_height, scale);
+    if (!file) return NULL;
+
+    if (atof(scale) >= 0.0) {
+        fprintf(stderr, "Only little-endian PFM files are supported: %s\n", path);
+        fclose(file);
+        return NULL;
+    }
+
+    int width = *out_width;
+    int height = *out_height;
+    float *values = malloc(sizeof(float) * width * height);
+    if (!values) {
+        fclose(file);
+        return NULL;
+    }
+
+    for (int y = height - 1; y >= 0; y--) {
+        if (fread(values + (size_t)y * width, sizeof(float), width, file) != (size_t)width) {
+            fprintf(stderr, "Failed to read depth data from %s\n", path);
+            free(values);
+            fclose(file);
+            return NULL;
+        }
+    }
+
+    fclose(file);
+    return values;
+}
@@ -0,0 +1,19 @@
+#ifndef IMAGE_IO_H
+#define IMAGE_IO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ==== Portable pixmap / float map I/O ====
+// Colour images are ARGB8888 (the rasterizer's pixelBuffer layout) in memory
+// and binary RGB PPM (P6) on disk. Depth uses little-endian PFM (Pf).
+// pitch is in pixels, so sub-rectangles and padded buffers can be written.
+
+bool WritePPM(const char *path, const uint32_t *pixels, int width, int height, int pitch);
+bool WritePFM(const char *path, const float *values, int width, int height);
+
+// Return malloc'd buffers, caller must free. NULL on failure.
+uint32_t* LoadPPM(const char *path, int *out_width, int *out_height);
+float* LoadPFM(const char *path, int *out_width, int *out_height);
+
+#endif
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <math.h>
@@ -11,6 +12,26 @@
 #include "calcs.h"
 #include "ImportObj.h"
 #include "eventMgr.h"
+#include "arena.h"
+#include "meshOpt.h"
+#include "meshlet.h"
+#include "pageFile.h"
+#include "pageStream.h"
+#include "msaa.h"
+#include "framePacer.h"
+#include "shadow.h"
+
+// Per-frame scratch memory, reset at the start of every frame
+#define FRAME_ARENA_SIZE (4 * 1024 * 1024)
+// Default triangle budget for streamed scenes
+#define DEFAULT_STREAM_BUDGET_MB 256
+#define FPS_STR_SIZE 192
+// Longest sleep while idle before checking again, keeps an idle window near 0% CPU
+#define IDLE_WAIT_MS 100
+// Shorter idle wait while streamed pages are still arriving
+#define STREAM_WAIT_MS 5
+// Texels per side of the sun's shadow map
+#define SHADOW_MAP_SIZE 1024
 
 int main(int argc, char* argv[]) {
     printf("TinyRasta by JimmyBinoculars\n");
@@ -31,19 +52,76 @@ int main(int argc, char* argv[]) {
 
     // Parse command-line flags
     char *obj_path = "../models/scene.obj"; // default path
+    bool optimizeOrder = false;
+    int benchFrames = 0; // Non-zero runs a fixed-camera benchmark then exits
+    char *convertPath = NULL; // Builds a page file from the OBJ then exits
+    char *streamPath = NULL;  // Streams a page file instead of loading an OBJ
+    int streamBudgetMB = DEFAULT_STREAM_BUDGET_MB;
+    bool useMsaa = false;
+    int targetFps = 0;     // 0 leaves the frame rate uncapped
+    bool useVsync = false;
+    bool useShadows = false;
+    bool shadowPcf = false;
     int opt;
-    while ((opt = getopt(argc, argv, "f:")) != -1) {
+    while ((opt = getopt(argc, argv, "f:ob:c:s:B:mr:vL:")) != -1) {
         switch (opt) {
             case 'f':
                 obj_path = optarg;
                 break;
+            case 'o':
+                optimizeOrder = true;
+                break;
+            case 'b':
+                benchFrames = atoi(optarg);
+                break;
+            case 'c':
+                convertPath = optarg;
+                break;
+            case 's':
+                streamPath = optarg;
+                break;
+            case 'B':
+                streamBudgetMB = atoi(optarg);
+                break;
+            case 'm':
+                useMsaa = true;
+                break;
+            case 'r':
+                targetFps = atoi(optarg);
+                break;
+            case 'v':
+                useVsync = true;
+                break;
+            case 'L':
+                if (strcmp(optarg, "pcf") != 0 && strcmp(optarg, "hard") != 0) {
+                    fprintf(stderr, "Unknown shadow mode '%s', expected pcf or hard\n", optarg);
+                    return 1;
+                }
+                useShadows = true;
+                shadowPcf = strcmp(optarg, "pcf") == 0;
+                break;
             default:
-                fprintf(stderr, "Usage: %s [-f obj_file_path]\n", argv[0]);
+                fprintf(stderr, "Usage: %s [-f obj_file_path] [-o] [-b bench_frames] [-c out.pages] "
+                        "[-s scene.pages] [-B budget_mb] [-m] [-r target_fps] [-v] [-L pcf|hard]\n", argv[0]);
                 return 1;
         }
     }
 
-    printf("OBJ path set to: %s\n", obj_path);
+    if (convertPath) {
+        printf("Building page file %s from %s\n", convertPath, obj_path);
+        return BuildPageFile(obj_path, convertPath) ? 0 : 1;
+    }
+
+    if (streamPath) {
+        printf("Streaming pages from: %s (budget %d MB)\n", streamPath, streamBudgetMB);
+        if (useShadows) {
+            // The shadow map needs every caster, which a streamed scene never has in memory
+            printf("Shadows are not supported when streaming, ignoring -L\n");
+            useShadows = false;
+        }
+    } else {
+        printf("OBJ path set to: %s\n", obj_path);
+    }
 
     SDL_Window* win = NULL;
     SDL_Renderer* ren = NULL;
@@ -54,37 +132,85 @@ int main(int argc, char* argv[]) {
     // Set our mouse mode
     SDL_SetWindowRelativeMouseMode(win, true);
 
-    FILE* test = fopen(obj_path, "r");
-    if (!test) {
-        fprintf(stderr, "Failed to open OBJ file: %s\n", obj_path);
-        return 1;
-    }
-    fclose(test);
-
     int triangleCount = 0;
-    Triangle* tris = LoadObjTriangles(obj_path, &triangleCount);
+    Triangle* tris = NULL;
+    Vec4* triangleColours = NULL;
+    int* triangleOrder = NULL;
+    MeshCullData cullData = {0};
+    float acmr = 0.0f;
+    PageStream *stream = NULL;
+
+    if (streamPath) {
+        // Streamed scenes are never fully in memory, pages arrive as the camera looks around
+        stream = OpenPageStream(streamPath, (size_t)streamBudgetMB * 1024 * 1024);
+        if (!stream) return 1;
+    } else {
+        FILE* test = fopen(obj_path, "r");
+        if (!test) {
+            fprintf(stderr, "Failed to open OBJ file: %s\n", obj_path);
+            return 1;
+        }
+        fclose(test);
 
-    if (!tris || triangleCount == 0) {
-        fprintf(stderr, "OBJ loading failed or returned 0 triangles!\n");
-        return 1;
-    }
+        tris = LoadObjTriangles(obj_path, &triangleCount);
 
-    Vec4* triangleColours = malloc(sizeof(Vec4) * triangleCount);
-    if (!triangleColours) {
-        fprintf(stderr, "Failed to allocate vertex colours!\n");
-        return 1;
-    }
+        if (!tris || triangleCount == 0) {
+            fprintf(stderr, "OBJ loading failed or returned 0 triangles!\n");
+            return 1;
+        }
 
-    for (int i = 0; i < triangleCount; i++) {
-        triangleColours[i] = (Vec4){
-            (float)(rand() % 256) / 255.0f,
-            (float)(rand() % 256) / 255.0f,
-            (float)(rand() % 256) / 255.0f,
-            1.0
-        };
-    }
+        triangleColours = malloc(sizeof(Vec4) * triangleCount);
+        triangleOrder = malloc(sizeof(int) * triangleCount);
+        if (!triangleColours || !triangleOrder) {
+            fprintf(stderr, "Failed to allocate vertex colours!\n");
+            return 1;
+        }
+
+        // Identity order unless the optimizer below reorders the triangles
+        for (int i = 0; i < triangleCount; i++) triangleOrder[i] = i;
+
+        acmr = ComputeACMR(tris, triangleCount, VERTEX_CACHE_SIZE);
+        printf("ACMR (file order): %.3f\n", acmr);
+
+        if (optimizeOrder) {
+            if (!OptimizeTriangleOrder(tris, triangleCount, triangleOrder)) {
+                fprintf(stderr, "Triangle reordering failed!\n");
+                return 1;
+            }
+            acmr = ComputeACMR(tris, triangleCount, VERTEX_CACHE_SIZE);
+            printf("ACMR (optimized): %.3f\n", acmr);
+        }
+
+        // Colours are drawn in original file order so each triangle keeps its colour
+        // regardless of reordering, then scattered to the triangle's new slot
+        Vec4* fileColours = malloc(sizeof(Vec4) * triangleCount);
+        if (!fileColours) {
+            fprintf(stderr, "Failed to allocate vertex colours!\n");
+            return 1;
+        }
+
+        for (int i = 0; i < triangleCount; i++) {
+            fileColours[i] = (Vec4){
+                (float)(rand() % 256) / 255.0f,
+                (float)(rand() % 256) / 255.0f,
+                (float)(rand() % 256) / 255.0f,
+                1.0
+            };
+        }
+
+        for (int i = 0; i < triangleCount; i++) {
+            triangleColours[i] = fileColours[triangleOrder[i]];
+        }
+        free(fileColours);
 
-    printf("Loaded %d triangles from %s\n", triangleCount, obj_path);
+        // Static geometry, so cluster bounds and face normals are built once here
+        if (!BuildMeshCullData(tris, triangleCount, &cullData)) {
+            fprintf(stderr, "Failed to build meshlets!\n");
+            return 1;
+        }
+
+        printf("Loaded %d triangles from %s\n", triangleCount, obj_path);
+    }
 
     Mat4 model = mat4_identity();
     Camera cam = {
@@ -94,7 +220,6 @@ int main(int argc, char* argv[]) {
     };
 
     Mat4 proj = mat4_perspective(70.0f * (3.14159f / 180.0f), (float)WIN_WIDTH / WIN_HEIGHT, 0.1f, 100.0f);
-    if (!tris) return 1;
 
     float* zbuffer = malloc(sizeof(float) * WIN_WIDTH * WIN_HEIGHT);
     if (!zbuffer) {
@@ -102,6 +227,8 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // Frames are drawn straight into the locked texture; this is only the
+    // fallback for renderers that refuse to lock it
     uint32_t *pixelBuffer = malloc(sizeof(uint32_t) * WIN_WIDTH * WIN_HEIGHT);
     if (!pixelBuffer) {
         fprintf(stderr, "Failed to allocate pixelBuffer");
@@ -115,7 +242,39 @@ int main(int argc, char* argv[]) {
         WIN_WIDTH, WIN_HEIGHT
     );
 
+    // The frame covers the whole target and nothing clears the backbuffer under
+    // it, so copy it as is rather than blending by its (cleared to zero) alpha
+    if (!texture || !SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE)) {
+        fprintf(stderr, "Failed to create frame texture: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    // 4x MSAA resolves into the frame's pixels, so the rest of the frame is unchanged
+    MsaaBuffer msaaBuffer = {0};
+    if (useMsaa && !MsaaInit(&msaaBuffer, WIN_WIDTH, WIN_HEIGHT)) return 1;
+    MsaaBuffer *msaa = useMsaa ? &msaaBuffer : NULL;
+
+    // Directional sun from above (the loader flips Y, so down is +Y), fitted to the whole scene
+    ShadowMap shadowMap = {0};
+    if (useShadows) {
+        if (!ShadowMapInit(&shadowMap, SHADOW_MAP_SIZE, shadowPcf)) return 1;
+        ShadowMapFitScene(&shadowMap, (Vec3){0.35f, 1.0f, 0.5f}, tris, triangleCount);
+    }
+    ShadowMap *shadow = useShadows ? &shadowMap : NULL;
+
+    // Overlay glyphs are rendered once here, the font isn't needed after that
     TTF_Font* font = TTF_OpenFont("./fonts/SF-Pro.ttf", 24);
+    GlyphAtlas atlas;
+    if (!GlyphAtlasInit(&atlas, ren, font)) {
+        fprintf(stderr, "Overlay text disabled, failed to build glyph atlas\n");
+    }
+    if (font) TTF_CloseFont(font);
+
+    Arena frameArena;
+    if (!arena_init(&frameArena, FRAME_ARENA_SIZE)) {
+        fprintf(stderr, "Failed to allocate frame arena");
+        return 1;
+    }
 
     bool running = true;
     SDL_Event event;
@@ -126,7 +285,7 @@ int main(int argc, char* argv[]) {
     uint64_t lastTime = SDL_GetPerformanceCounter();
     double freq = (double)SDL_GetPerformanceFrequency();
     int frames = 0;
-    char *fps_str = malloc(128);
+    char *fps_str = malloc(FPS_STR_SIZE);
     if (!fps_str) {
         fprintf(stderr, "Failed to allocate fps_str");
         return 1;
@@ -134,13 +293,60 @@ int main(int argc, char* argv[]) {
     double fpsTimer = 0.0;
     int fps = 0;
 
-    int vSync = SDL_GetHintBoolean("SDL_RENDER_VSYNC", false);
+    // Vsync is set on the renderer once and read back, since drivers may refuse it
+    if (!SDL_SetRenderVSync(ren, useVsync ? 1 : SDL_RENDERER_VSYNC_DISABLED)) {
+        fprintf(stderr, "Failed to set vsync: %s\n", SDL_GetError());
+    }
+    int vSync = 0;
+    SDL_GetRenderVSync(ren, &vSync);
+
+    FramePacer pacer;
+    FramePacerInit(&pacer, targetFps);
+
+    // The scene is static, so frames are only redrawn when something changes
+    bool needsRedraw = true;
+    uint64_t lastLoadsDone = 0;
+
+    int benchFramesDone = 0;
+    double benchTime = 0.0;
+    uint64_t benchExpanded = 0;
+    uint64_t benchSlopes = 0;
+    double benchShadowTime = 0.0;
+
+    // Camera velocity drives page prefetching ahead of the view
+    Vec3 prevCamPos = cam.position;
 
     while (running) {
         uint64_t currentTime = SDL_GetPerformanceCounter();
         double deltaTime = (currentTime - lastTime) / freq;
         lastTime = currentTime;
-        vSync = SDL_GetHintBoolean("SDL_RENDER_VSYNC", false);
+        arena_reset(&frameArena);
+
+        // Benchmarks keep the camera fixed and render every frame so runs are comparable
+        if (benchFrames > 0) {
+            SDL_PumpEvents();
+            needsRedraw = true;
+        } else if (HandleEvents(&running, &cam, rotSpeed, moveSpeed, PITCH_LIMIT, deltaTime, MOUSE_SENSITIVITY)) {
+            needsRedraw = true;
+        }
+
+        // Newly arrived pages change the picture even with a still camera
+        PageStreamStats streamStats = {0};
+        if (stream) {
+            PageStreamGetStats(stream, &streamStats);
+            if (streamStats.loadsDone != lastLoadsDone) needsRedraw = true;
+            lastLoadsDone = streamStats.loadsDone;
+        }
+
+        if (!needsRedraw) {
+            // Nothing would change on screen: sleep until input arrives instead of
+            // re-rendering the same frame. The event stays queued for HandleEvents.
+            SDL_WaitEventTimeout(NULL, streamStats.pendingLoads > 0 ? STREAM_WAIT_MS : IDLE_WAIT_MS);
+            fpsTimer = 0.0;
+            frames = 0;
+            continue;
+        }
+        needsRedraw = false;
 
         fpsTimer += deltaTime;
         frames++;
@@ -152,22 +358,80 @@ int main(int argc, char* argv[]) {
             frames = 0;
         }
 
-        HandleEvents(&running, &cam, rotSpeed, moveSpeed, PITCH_LIMIT, deltaTime, MOUSE_SENSITIVITY);
-
         Vec3 cam_forward = get_camera_forward(cam);
         Vec3 cam_target  = vec3_add(cam.position, cam_forward);
         Vec3 cam_up      = {0, 1, 0};
         Mat4 view        = mat4_look_at(cam.position, cam_target, cam_up);
         Mat4 mvp         = mat4_mul(proj, mat4_mul(view, model));
-        
-        snprintf(fps_str, 128, "fps: %d \n cam: (%.2f, %.2f, %.2f) \n yaw: %.2f | pitch: %.2f \n vsync: %s",
+
+        Vec3 camVelocity = {0, 0, 0};
+        if (deltaTime > 0.0) {
+            camVelocity = vec3_scale(vec3_sub(cam.position, prevCamPos), (float)(1.0 / deltaTime));
+        }
+        prevCamPos = cam.position;
+
+        if (stream) {
+            PageStreamUpdate(stream, mvp, cam.position, camVelocity);
+            PageStreamGetStats(stream, &streamStats);
+        }
+
+        int textLen = snprintf(fps_str, FPS_STR_SIZE, "fps: %d \n cam: (%.2f, %.2f, %.2f) \n yaw: %.2f | pitch: %.2f \n vsync: %s",
             fps, cam.position.x, cam.position.y, cam.position.z,
             cam.yaw, cam.pitch, vSync ? "enabled" : "disabled");
+        if (stream && textLen > 0 && textLen < FPS_STR_SIZE) {
+            snprintf(fps_str + textLen, FPS_STR_SIZE - textLen, " \n pages: %d/%d visible, %d loading",
+                streamStats.visiblePages, streamStats.pageCount, streamStats.pendingLoads);
+        }
+
+        // The light pass runs every frame, as it would with moving lights or objects
+        if (shadow) {
+            uint64_t shadowStart = SDL_GetPerformanceCounter();
+            RenderShadowMap(shadow, tris, triangleCount);
+            benchShadowTime += (SDL_GetPerformanceCounter() - shadowStart) / freq;
+        }
 
-        renderLoop(ren, WIN_HEIGHT, WIN_WIDTH, zbuffer, triangleCount, view, model,
-                tris, cam, mvp, triangleColours, pixelBuffer, texture, font, fps_str);
+        renderLoop(ren, WIN_HEIGHT, WIN_WIDTH, zbuffer, model,
+                tris, cam, mvp, triangleColours, &cullData, pixelBuffer, texture, fps_str,
+                &atlas, &frameArena, stream, msaa, shadow);
+
+        if (benchFrames > 0) {
+            benchTime += (SDL_GetPerformanceCounter() - currentTime) / freq;
+            if (msaa) {
+                benchExpanded += msaa->blockCount;
+                benchSlopes += msaa->slopeCount;
+            }
+            if (++benchFramesDone >= benchFrames) {
+                printf("Benchmark: %d frames, %.3f ms/frame, %d triangles, ACMR %.3f (FIFO %d)\n",
+                    benchFramesDone, benchTime * 1000.0 / benchFramesDone, triangleCount,
+                    acmr, VERTEX_CACHE_SIZE);
+                if (msaa) {
+                    // Traffic estimate: compressed pixels hold depth, colour and meta; edge
+                    // pixels add a sample block. Compared against plain and 4x supersampled.
+                    int totalPixels = WIN_WIDTH * WIN_HEIGHT;
+                    double expanded = (double)benchExpanded / benchFramesDone;
+                    double msaaBytes = totalPixels * (sizeof(float) + 2 * sizeof(uint32_t))
+                        + expanded * sizeof(MsaaSampleBlock) + (double)benchSlopes / benchFramesDone * sizeof(Vec2);
+                    double plainBytes = totalPixels * (sizeof(float) + sizeof(uint32_t));
+                    printf("MSAA %dx: %.0f edge pixels/frame (%.2f%%), %.2f MB/frame vs %.2f MB 1x, %.2f MB %dx SSAA\n",
+                        MSAA_SAMPLES, expanded, 100.0 * expanded / totalPixels, msaaBytes / (1024.0 * 1024.0),
+                        plainBytes / (1024.0 * 1024.0), plainBytes * MSAA_SAMPLES / (1024.0 * 1024.0), MSAA_SAMPLES);
+                }
+                if (shadow) {
+                    printf("Shadows (%s, %dx%d map): %.3f ms/frame in the depth-only light pass\n",
+                        shadow->pcf ? "3x3 PCF" : "hard", shadow->size, shadow->size,
+                        benchShadowTime * 1000.0 / benchFramesDone);
+                }
+                if (stream) {
+                    printf("Streaming: %d pages, %d slots, %d visible, %d drawn, %llu loads\n",
+                        streamStats.pageCount, streamStats.slotCount, streamStats.visiblePages,
+                        streamStats.drawnPages, (unsigned long long)streamStats.loadsDone);
+                }
+                running = false;
+            }
+        }
 
-        // SDL_Delay(16);
+        // Hold to the target rate; benchmarks always run flat out
+        if (benchFrames == 0) FramePacerWait(&pacer);
     }
 
     // Reset our mouse
@@ -178,11 +442,18 @@ int main(int argc, char* argv[]) {
     SDL_DestroyRenderer(ren);
     SDL_DestroyWindow(win);
     SDL_DestroyTexture(texture);
+    GlyphAtlasDestroy(&atlas);
+    ClosePageStream(stream);
     SDL_Quit();
     free(tris);
     free(triangleColours);
+    free(triangleOrder);
+    FreeMeshCullData(&cullData);
     free(zbuffer);
     free(pixelBuffer);
+    MsaaDestroy(&msaaBuffer);
+    ShadowMapDestroy(&shadowMap);
     free(fps_str);
+    arena_destroy(&frameArena);
     return 0;
 }
@@ -0,0 +1,335 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "meshOpt.h"
+
+// Forsyth "Linear-Speed Vertex Cache Optimisation" tuning constants
+#define FORSYTH_CACHE_DECAY_POWER   1.5f
+#define FORSYTH_LAST_TRI_SCORE      0.75f
+#define FORSYTH_VALENCE_BOOST_SCALE 2.0f
+#define FORSYTH_VALENCE_BOOST_POWER 0.5f
+
+// Triangles per cluster when sorting the cache-optimized order for overdraw.
+// Smaller clusters cut more overdraw but break vertex reuse at every boundary.
+#define OVERDRAW_CLUSTER_SIZE 256
+
+// ===== Vertex welding =====
+
+static uint32_t HashPosition(Vec3 p) {
+    uint32_t bits[3];
+    memcpy(bits, &p, sizeof(bits));
+    return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+}
+
+int WeldTriangleVertices(const Triangle *tris, int triCount, int *indices) {
+    int cornerCount = triCount * 3;
+
+    // Open addressing table, at least twice the number of corners
+    int tableSize = 1;
+    while (tableSize < cornerCount * 2) tableSize <<= 1;
+
+    int *table = malloc(sizeof(int) * tableSize);
+    Vec3 *unique = malloc(sizeof(Vec3) * (cornerCount > 0 ? cornerCount : 1));
+    if (!table || !unique) {
+        fprintf(stderr, "Failed to allocate vertex weld tables\n");
+        free(table);
+        free(unique);
+        return -1;
+    }
+    memset(table, -1, sizeof(int) * tableSize);
+
+    int vertCount = 0;
+    for (int c = 0; c < cornerCount; c++) {
+        const Triangle *tri = &tris[c / 3];
+        Vec3 p = (c % 3 == 0) ? tri->v0.pos : (c % 3 == 1) ? tri->v1.pos : tri->v2.pos;
+
+        uint32_t slot = HashPosition(p) & (uint32_t)(tableSize - 1);
+        while (table[slot] >= 0 && memcmp(&unique[table[slot]], &p, sizeof(Vec3)) != 0) {
+            slot = (slot + 1) & (uint32_t)(tableSize - 1);
+        }
+
+        if (table[slot] < 0) {
+            unique[vertCount] = p;
+            table[slot] = vertCount++;
+        }
+        indices[c] = table[slot];
+    }
+
+    free(table);
+    free(unique);
+    return vertCount;
+}
+
+// ===== ACMR =====
+
+float ComputeACMR(const Triangle *tris, int triCount, int cacheSize) {
+    if (triCount <= 0) return 0.0f;
+
+    int *indices = malloc(sizeof(int) * triCount * 3);
+    if (!indices) return -1.0f;
+
+    int vertCount = WeldTriangleVertices(tris, triCount, indices);
+    int *insertedAt = vertCount > 0 ? malloc(sizeof(int) * vertCount) : NULL;
+    if (!insertedAt) {
+        free(indices);
+        return -1.0f;
+    }
+
+    // A vertex is still in the FIFO if fewer than cacheSize misses happened since it went in
+    for (int v = 0; v < vertCount; v++) insertedAt[v] = -cacheSize - 1;
+
+    int misses = 0;
+    for (int c = 0; c < triCount * 3; c++) {
+        int v = indices[c];
+        if (misses - insertedAt[v] >= cacheSize) {
+            insertedAt[v] = misses++;
+        }
+    }
+
+    free(insertedAt);
+    free(indices);
+    return (float)misses / (float)triCount;
+}
+
+// ===== Forsyth vertex cache ordering =====
+
+static float ForsythVertexScore(int cachePos, int remaining) {
+    if (remaining == 0) return -1.0f; // No triangles left need this vertex
+
+    float score = 0.0f;
+    if (cachePos >= 0) {
+        if (cachePos < 3) {
+            // Used by the last triangle, fixed score so it doesn't dominate
+            score = FORSYTH_LAST_TRI_SCORE;
+        } else {
+            float scaler = 1.0f / (VERTEX_CACHE_SIZE - 3);
+            score = powf(1.0f - (cachePos - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+        }
+    }
+
+    // Boost vertices with few remaining triangles so we finish off lone triangles
+    score += FORSYTH_VALENCE_BOOST_SCALE * powf((float)remaining, -FORSYTH_VALENCE_BOOST_POWER);
+    return score;
+}
+
+static bool ForsythOrder(const int *indices, int triCount, int vertCount, int *order) {
+    int *adjOffset = calloc((size_t)vertCount + 1, sizeof(int));
+    int *adjTris = malloc(sizeof(int) * triCount * 3);
+    int *remaining = calloc((size_t)vertCount, sizeof(int));
+    int *cachePos = malloc(sizeof(int) * vertCount);
+    float *vertScore = malloc(sizeof(float) * vertCount);
+    float *triScore = malloc(sizeof(float) * triCount);
+    bool *emitted = calloc((size_t)triCount, sizeof(bool));
+
+    if (!adjOffset || !adjTris || !remaining || !cachePos || !vertScore || !triScore || !emitted) {
+        fprintf(stderr, "Failed to allocate vertex cache optimizer state\n");
+        free(adjOffset); free(adjTris); free(remaining); free(cachePos);
+        free(vertScore); free(triScore); free(emitted);
+        return false;
+    }
+
+    // Build vertex -> triangle adjacency (CSR layout)
+    for (int c = 0; c < triCount * 3; c++) adjOffset[indices[c] + 1]++;
+    for (int v = 0; v < vertCount; v++) adjOffset[v + 1] += adjOffset[v];
+    for (int c = 0; c < triCount * 3; c++) {
+        int v = indices[c];
+        adjTris[adjOffset[v] + remaining[v]++] = c / 3;
+    }
+
+    for (int v = 0; v < vertCount; v++) {
+        cachePos[v] = -1;
+        vertScore[v] = ForsythVertexScore(-1, remaining[v]);
+    }
+
+    int bestTri = -1;
+    float bestScore = -1.0f;
+    for (int t = 0; t < triCount; t++) {
+        triScore[t] = vertScore[indices[t * 3]] + vertScore[indices[t * 3 + 1]] + vertScore[indices[t * 3 + 2]];
+        if (triScore[t] > bestScore) {
+            bestScore = triScore[t];
+            bestTri = t;
+        }
+    }
+
+    int cache[VERTEX_CACHE_SIZE + 3];
+    int cacheCount = 0;
+    int cursor = 0;
+
+    for (int out = 0; out < triCount; out++) {
+        // No scored candidate left in the cache: fall back to the next unemitted triangle
+        if (bestTri < 0) {
+            while (emitted[cursor]) cursor++;
+            bestTri = cursor;
+        }
+
+        int t = bestTri;
+        const int *tv = &indices[t * 3];
+        emitted[t] = true;
+        order[out] = t;
+
+        // Remove the triangle from its vertices' remaining lists
+        for (int k = 0; k < 3; k++) {
+            int v = tv[k];
+            int *list = &adjTris[adjOffset[v]];
+            for (int i = 0; i < remaining[v]; i++) {
+                if (list[i] == t) {
+                    list[i] = list[--remaining[v]];
+                    break;
+                }
+            }
+        }
+
+        // Move the triangle's vertices to the front of the LRU cache
+        int newCache[VERTEX_CACHE_SIZE + 3];
+        int newCount = 0;
+        for (int k = 0; k < 3; k++) {
+            bool present = false;
+            for (int i = 0; i < newCount; i++) present |= (newCache[i] == tv[k]);
+            if (!present) newCache[newCount++] = tv[k];
+        }
+        for (int i = 0; i < cacheCount; i++) {
+            int v = cache[i];
+            if (v != tv[0] && v != tv[1] && v != tv[2]) newCache[newCount++] = v;
+        }
+
+        // Rescore every vertex that moved, including those just evicted
+        for (int i = 0; i < newCount; i++) {
+            int v = newCache[i];
+            cachePos[v] = i < VERTEX_CACHE_SIZE ? i : -1;
+            vertScore[v] = ForsythVertexScore(cachePos[v], remaining[v]);
+        }
+
+        cacheCount = newCount < VERTEX_CACHE_SIZE ? newCount : VERTEX_CACHE_SIZE;
+        memcpy(cache, newCache, sizeof(int) * cacheCount);
+
+        // Rescore the triangles touching those vertices and pick the next best
+        bestTri = -1;
+        bestScore = -1.0f;
+        for (int i = 0; i < newCount; i++) {
+            int v = newCache[i];
+            const int *list = &adjTris[adjOffset[v]];
+            for (int j = 0; j < remaining[v]; j++) {
+                int a = list[j];
+                const int *av = &indices[a * 3];
+                triScore[a] = vertScore[av[0]] + vertScore[av[1]] + vertScore[av[2]];
+                if (triScore[a] > bestScore) {
+                    bestScore = triScore[a];
+                    bestTri = a;
+                }
+            }
+        }
+    }
+
+    free(adjOffset); free(adjTris); free(remaining); free(cachePos);
+    free(vertScore); free(triScore); free(emitted);
+    return true;
+}
+
+// ===== Overdraw cluster sort =====
+
+typedef struct {
+    float key;
+    int first;
+    int count;
+} TriCluster;
+
+static int CompareClusters(const void *a, const void *b) {
+    const TriCluster *ca = a;
+    const TriCluster *cb = b;
+    if (ca->key != cb->key) return ca->key > cb->key ? -1 : 1; // Outward-facing first
+    return ca->first - cb->first;
+}
+
+// Splits the cache-ordered triangles into small clusters and draws the ones facing
+// away from the mesh centre first, since they tend to occlude the rest. Each cluster
+// stays contiguous so vertex cache reuse and screen-space locality are kept.
+static bool SortClustersForOverdraw(const Triangle *tris, int triCount, int *order) {
+    int clusterCount = (triCount + OVERDRAW_CLUSTER_SIZE - 1) / OVERDRAW_CLUSTER_SIZE;
+    TriCluster *clusters = malloc(sizeof(TriCluster) * clusterCount);
+    Vec3 *centroids = malloc(sizeof(Vec3) * clusterCount);
+    Vec3 *normals = malloc(sizeof(Vec3) * clusterCount);
+    int *sorted = malloc(sizeof(int) * triCount);
+    if (!clusters || !centroids || !normals || !sorted) {
+        free(clusters); free(centroids); free(normals); free(sorted);
+        return false;
+    }
+
+    Vec3 meshCentroid = {0, 0, 0};
+    float meshArea = 0.0f;
+
+    for (int c = 0; c < clusterCount; c++) {
+        clusters[c].first = c * OVERDRAW_CLUSTER_SIZE;
+        clusters[c].count = triCount - clusters[c].first;
+        if (clusters[c].count > OVERDRAW_CLUSTER_SIZE) clusters[c].count = OVERDRAW_CLUSTER_SIZE;
+
+        // Area weighted centroid and normal of the cluster
+        Vec3 centroid = {0, 0, 0};
+        Vec3 normal = {0, 0, 0};
+        float area = 0.0f;
+        for (int i = clusters[c].first; i < clusters[c].first + clusters[c].count; i++) {
+            const Triangle *tri = &tris[order[i]];
+            Vec3 cross = vec3_cross(vec3_sub(tri->v1.pos, tri->v0.pos), vec3_sub(tri->v2.pos, tri->v0.pos));
+            float triArea = vec3_length(cross);
+            Vec3 triCentroid = vec3_scale(vec3_add(vec3_add(tri->v0.pos, tri->v1.pos), tri->v2.pos), 1.0f / 3.0f);
+
+            centroid = vec3_add(centroid, vec3_scale(triCentroid, triArea));
+            normal = vec3_add(normal, cross);
+            area += triArea;
+        }
+
+        meshCentroid = vec3_add(meshCentroid, centroid);
+        meshArea += area;
+
+        centroids[c] = area > 0.0f ? vec3_scale(centroid, 1.0f / area) : centroid;
+        normals[c] = vec3_normalize(normal);
+    }
+
+    if (meshArea > 0.0f) meshCentroid = vec3_scale(meshCentroid, 1.0f / meshArea);
+
+    for (int c = 0; c < clusterCount; c++) {
+        clusters[c].key = vec3_dot(vec3_sub(centroids[c], meshCentroid), normals[c]);
+    }
+
+    qsort(clusters, clusterCount, sizeof(TriCluster), CompareClusters);
+
+    int out = 0;
+    for (int c = 0; c < clusterCount; c++) {
+        memcpy(&sorted[out], &order[clusters[c].first], sizeof(int) * clusters[c].count);
+        out += clusters[c].count;
+    }
+    memcpy(order, sorted, sizeof(int) * triCount);
+
+    free(clusters); free(centroids); free(normals); free(sorted);
+    return true;
+}
+
+// ===== Public entry point =====
+
+bool OptimizeTriangleOrder(Triangle *tris, int triCount, int *order) {
+    if (triCount <= 0) return true;
+
+    int *indices = malloc(sizeof(int) * triCount * 3);
+    Triangle *reordered = malloc(sizeof(Triangle) * triCount);
+    if (!indices || !reordered) {
+        fprintf(stderr, "Failed to allocate triangle reorder buffers\n");
+        free(indices);
+        free(reordered);
+        return false;
+    }
+
+    int vertCount = WeldTriangleVertices(tris, triCount, indices);
+    bool ok = vertCount > 0
+        && ForsythOrder(indices, triCount, vertCount, order)
+        && SortClustersForOverdraw(tris, triCount, order);
+
+    if (ok) {
+        for (int i = 0; i < triCount; i++) reordered[i] = tris[order[i]];
+        memcpy(tris, reordered, sizeof(Triangle) * triCount);
+    }
+
+    free(indices);
+    free(reordered);
+    return ok;
+}
@@ -0,0 +1,23 @@
+#ifndef MESH_OPT_H
+#define MESH_OPT_H
+
+#include <stdbool.h>
+#include "calcs.h"
+
+// Post-transform vertex cache size assumed by the optimizer and ACMR metric
+#define VERTEX_CACHE_SIZE 32
+
+// Welds bitwise-identical positions into shared vertex indices.
+// indices must hold 3 * triCount ints. Returns the unique vertex count, or -1 on failure.
+int WeldTriangleVertices(const Triangle *tris, int triCount, int *indices);
+
+// Average cache miss ratio: vertices transformed per triangle with a FIFO cache
+// of cacheSize entries. 0.5 is the theoretical best, 3.0 the worst.
+float ComputeACMR(const Triangle *tris, int triCount, int cacheSize);
+
+// Reorders tris in place for vertex cache reuse (Forsyth) and then sorts
+// small clusters of the result outward-facing first to cut overdraw.
+// order[i] receives the original index of the triangle now at position i.
+bool OptimizeTriangleOrder(Triangle *tris, int triCount, int *order);
+
+#endif
@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include "meshlet.h"
+
+// Centroids are quantized to this many bits per axis for the Morton code
+#define MESHLET_MORTON_BITS 10
+
+typedef struct {
+    uint64_t key;   // Normal octant above the centroid's Morton code
+    int tri;
+} MeshletSortKey;
+
+// ===== Load-time build =====
+
+// Spreads the low 10 bits of v out to every third bit
+static uint32_t SpreadMortonBits(uint32_t v) {
+    v &= 0x3FF;
+    v = (v | (v << 16)) & 0x030000FF;
+    v = (v | (v << 8)) & 0x0300F00F;
+    v = (v | (v << 4)) & 0x030C30C3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+
+static int CompareSortKeys(const void *a, const void *b) {
+    const MeshletSortKey *ka = a;
+    const MeshletSortKey *kb = b;
+    if (ka->key != kb->key) return ka->key < kb->key ? -1 : 1;
+    return ka->tri - kb->tri;
+}
+
+static int CompareInts(const void *a, const void *b) {
+    int ia = *(const int *)a;
+    int ib = *(const int *)b;
+    return (ia > ib) - (ia < ib);
+}
+
+static void ComputeMeshletBounds(const Triangle *tris, const int *meshletTris, const Vec4 *facePlanes,
+        Meshlet *m) {
+    const int *run = &meshletTris[m->firstTri];
+
+    // Sphere around the AABB centre
+    Vec3 minP = tris[run[0]].v0.pos;
+    Vec3 maxP = tris[run[0]].v0.pos;
+    for (int j = 0; j < m->triCount; j++) {
+        int i = run[j];
+        const Vec3 corners[3] = { tris[i].v0.pos, tris[i].v1.pos, tris[i].v2.pos };
+        for (int k = 0; k < 3; k++) {
+            minP.x = fminf(minP.x, corners[k].x); maxP.x = fmaxf(maxP.x, corners[k].x);
+            minP.y = fminf(minP.y, corners[k].y); maxP.y = fmaxf(maxP.y, corners[k].y);
+            minP.z = fminf(minP.z, corners[k].z); maxP.z = fmaxf(maxP.z, corners[k].z);
+        }
+    }
+
+    m->center = vec3_scale(vec3_add(minP, maxP), 0.5f);
+    m->radius = 0.0f;
+    for (int j = 0; j < m->triCount; j++) {
+        int i = run[j];
+        const Vec3 corners[3] = { tris[i].v0.pos, tris[i].v1.pos, tris[i].v2.pos };
+        for (int k = 0; k < 3; k++) {
+            m->radius = fmaxf(m->radius, vec3_length(vec3_sub(corners[k], m->center)));
+        }
+    }
+
+    // Normal cone: axis is the mean normal, half-angle covers the widest face normal
+    Vec3 axis = {0, 0, 0};
+    for (int j = 0; j < m->triCount; j++) {
+        axis = vec3_add(axis, vec3_from_vec4(facePlanes[run[j]]));
+    }
+    m->coneAxis = vec3_normalize(axis);
+
+    float minDot = 1.0f;
+    for (int j = 0; j < m->triCount; j++) {
+        Vec3 n = vec3_from_vec4(facePlanes[run[j]]);
+        if (vec3_dot(n, n) == 0.0f) continue; // Degenerate triangle, always drawn anyway
+        minDot = fminf(minDot, vec3_dot(n, m->coneAxis));
+    }
+
+    if (vec3_dot(axis, axis) == 0.0f || minDot <= 0.0f) {
+        // Normals span a hemisphere or more, the cone can never reject this cluster
+        m->coneCos = 0.0f;
+        m->coneSin = 1.0f;
+    } else {
+        m->coneCos = minDot;
+        m->coneSin = sqrtf(fmaxf(0.0f, 1.0f - minDot * minDot));
+    }
+}
+
+bool BuildMeshCullData(const Triangle *tris, int triCount, MeshCullData *out) {
+    // Each of the 8 octants can leave one partly filled meshlet behind
+    int maxMeshlets = (triCount + MESHLET_MAX_TRIS - 1) / MESHLET_MAX_TRIS + 8;
+    out->meshletCount = 0;
+    out->meshlets = malloc(sizeof(Meshlet) * maxMeshlets);
+    out->meshletTris = malloc(sizeof(int) * (triCount > 0 ? triCount : 1));
+    out->facePlanes = malloc(sizeof(Vec4) * (triCount > 0 ? triCount : 1));
+    MeshletSortKey *keys = malloc(sizeof(MeshletSortKey) * (triCount > 0 ? triCount : 1));
+    Meshlet *built = malloc(sizeof(Meshlet) * maxMeshlets);
+    if (!out->meshlets || !out->meshletTris || !out->facePlanes || !keys || !built) {
+        fprintf(stderr, "Failed to allocate meshlet data\n");
+        free(keys);
+        free(built);
+        FreeMeshCullData(out);
+        return false;
+    }
+
+    // Face normals use the same winding renderLoop always culled with
+    Vec3 minC = { INFINITY, INFINITY, INFINITY };
+    Vec3 maxC = { -INFINITY, -INFINITY, -INFINITY };
+    for (int i = 0; i < triCount; i++) {
+        Vec3 edge1 = vec3_sub(tris[i].v1.pos, tris[i].v0.pos);
+        Vec3 edge2 = vec3_sub(tris[i].v2.pos, tris[i].v0.pos);
+        Vec3 normal = vec3_normalize(vec3_cross(edge1, edge2));
+        out->facePlanes[i] = vec4_from_vec3(normal, vec3_dot(normal, tris[i].v0.pos));
+
+        Vec3 c = vec3_scale(vec3_add(vec3_add(tris[i].v0.pos, tris[i].v1.pos), tris[i].v2.pos), 1.0f / 3.0f);
+        minC.x = fminf(minC.x, c.x); maxC.x = fmaxf(maxC.x, c.x);
+        minC.y = fminf(minC.y, c.y); maxC.y = fmaxf(maxC.y, c.y);
+        minC.z = fminf(minC.z, c.z); maxC.z = fmaxf(maxC.z, c.z);
+    }
+
+    // Quantize centroids on a cube grid over their bounds so every axis gets the same resolution
+    float extent = fmaxf(maxC.x - minC.x, fmaxf(maxC.y - minC.y, maxC.z - minC.z));
+    float scale = extent > 0.0f ? (float)((1 << MESHLET_MORTON_BITS) - 1) / extent : 0.0f;
+    for (int i = 0; i < triCount; i++) {
+        Vec3 c = vec3_scale(vec3_add(vec3_add(tris[i].v0.pos, tris[i].v1.pos), tris[i].v2.pos), 1.0f / 3.0f);
+        uint32_t qx = (uint32_t)((c.x - minC.x) * scale);
+        uint32_t qy = (uint32_t)((c.y - minC.y) * scale);
+        uint32_t qz = (uint32_t)((c.z - minC.z) * scale);
+        uint32_t morton = SpreadMortonBits(qx) | (SpreadMortonBits(qy) << 1) | (SpreadMortonBits(qz) << 2);
+
+        Vec4 n = out->facePlanes[i];
+        uint32_t octant = (n.x < 0.0f) | ((n.y < 0.0f) << 1) | ((n.z < 0.0f) << 2);
+        keys[i] = (MeshletSortKey){ ((uint64_t)octant << (3 * MESHLET_MORTON_BITS)) | morton, i };
+    }
+    qsort(keys, triCount, sizeof(MeshletSortKey), CompareSortKeys);
+
+    // Cut the sorted order into runs, starting a new one at each octant
+    for (int i = 0; i < triCount; i++) out->meshletTris[i] = keys[i].tri;
+    int start = 0;
+    while (start < triCount) {
+        uint64_t octant = keys[start].key >> (3 * MESHLET_MORTON_BITS);
+        int end = start + 1;
+        while (end < triCount && end - start < MESHLET_MAX_TRIS &&
+                (keys[end].key >> (3 * MESHLET_MORTON_BITS)) == octant) {
+            end++;
+        }
+
+        Meshlet *meshlet = &built[out->meshletCount++];
+        meshlet->firstTri = start;
+        meshlet->triCount = end - start;
+        qsort(&out->meshletTris[start], end - start, sizeof(int), CompareInts);
+        ComputeMeshletBounds(tris, out->meshletTris, out->facePlanes, meshlet);
+        start = end;
+    }
+
+    // Draw meshlets in the order of their first triangle, reusing the keys
+    for (int m = 0; m < out->meshletCount; m++) {
+        keys[m] = (MeshletSortKey){ (uint64_t)out->meshletTris[built[m].firstTri], m };
+    }
+    qsort(keys, out->meshletCount, sizeof(MeshletSortKey), CompareSortKeys);
+    for (int m = 0; m < out->meshletCount; m++) out->meshlets[m] = built[keys[m].tri];
+
+    free(keys);
+    free(built);
+    return true;
+}
+
+void FreeMeshCullData(MeshCullData *data) {
+    free(data->meshlets);
+    free(data->meshletTris);
+    free(data->facePlanes);
+    data->meshlets = NULL;
+    data->meshletTris = NULL;
+    data->facePlanes = NULL;
+    data->meshletCount = 0;
+}
+
+// ===== Per-frame tests =====
+
+void ExtractFrustumPlanes(Mat4 mvp, Vec4 planes[FRUSTUM_PLANE_COUNT]) {
+    // Visible points have clip w < 0 (see DrawTriangle), so the volume is
+    // |x| <= -w, |y| <= -w, -w > 0 rather than the usual w-positive form
+    Vec4 row0 = { mvp.m[0][0], mvp.m[0][1], mvp.m[0][2], mvp.m[0][3] };
+    Vec4 row1 = { mvp.m[1][0], mvp.m[1][1], mvp.m[1][2], mvp.m[1][3] };
+    Vec4 negW = { -mvp.m[3][0], -mvp.m[3][1], -mvp.m[3][2], -mvp.m[3][3] };
+
+    planes[0] = (Vec4){ negW.x + row0.x, negW.y + row0.y, negW.z + row0.z, negW.w + row0.w };
+    planes[1] = (Vec4){ negW.x - row0.x, negW.y - row0.y, negW.z - row0.z, negW.w - row0.w };
+    planes[2] = (Vec4){ negW.x + row1.x, negW.y + row1.y, negW.z + row1.z, negW.w + row1.w };
+    planes[3] = (Vec4){ negW.x - row1.x, negW.y - row1.y, negW.z - row1.z, negW.w - row1.w };
+    planes[4] = negW;
+
+    // Normalize so the plane distance can be compared against sphere radii
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+        float len = vec3_length(vec3_from_vec4(planes[i]));
+        if (len > 0.0f) planes[i] = vec4_scale(planes[i], 1.0f / len);
+    }
+}
+
+bool MeshletVisible(const Meshlet *meshlet, const Vec4 planes[FRUSTUM_PLANE_COUNT], Vec3 camModel) {
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+        float dist = planes[i].x * meshlet->center.x + planes[i].y * meshlet->center.y
+                   + planes[i].z * meshlet->center.z + planes[i].w;
+        if (dist < -meshlet->radius) return false;
+    }
+
+    if (meshlet->coneCos <= 0.0f) return true;
+
+    // Back-facing cone: every face normal must point away from every point of the
+    // sphere as seen from the camera, i.e. angle(axis, view) + cone half-angle
+    // leaves at least radius/distance of margin below 90 degrees
+    Vec3 view = vec3_sub(meshlet->center, camModel);
+    float dist = vec3_length(view);
+    if (dist <= meshlet->radius) return true; // Camera inside the sphere
+
+    float cosView = vec3_dot(view, meshlet->coneAxis) / dist;
+    if (cosView <= 0.0f) return true;
+    float sinView = sqrtf(fmaxf(0.0f, 1.0f - cosView * cosView));
+
+    float cosCombined = cosView * meshlet->coneCos - sinView * meshlet->coneSin;
+    return cosCombined <= meshlet->radius / dist;
+}
@@ -0,0 +1,54 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include <stdbool.h>
+#include "calcs.h"
+
+// Triangles per meshlet. Meshlets are built spatially (see BuildMeshCullData),
+// so they are tight whatever order the triangles are in.
+#define MESHLET_MAX_TRIS 64
+
+// ==== Cluster bounds ====
+// All data is in model space and computed once at load time.
+
+typedef struct {
+    Vec3 center;     // Bounding sphere
+    float radius;
+    Vec3 coneAxis;   // Average face normal
+    float coneCos;   // cos/sin of the cone half-angle; coneCos <= 0 disables the cone test
+    float coneSin;
+    int firstTri;    // Run of triCount entries in MeshCullData.meshletTris
+    int triCount;
+} Meshlet;
+
+typedef struct {
+    Meshlet *meshlets;
+    int meshletCount;
+    int *meshletTris; // Triangle indices of every meshlet, one run each
+    Vec4 *facePlanes; // Per triangle: xyz = unit face normal, w = dot(normal, v0)
+} MeshCullData;
+
+// Groups triangles that face roughly the same way and sit close together:
+// sorted by face normal octant, then by the Morton code of the centroid, and
+// cut into runs of at most MESHLET_MAX_TRIS that never span two octants.
+// Triangles keep their array order within a meshlet and meshlets are ordered
+// by their first triangle, so a load-time reorder (-o) still sets draw order.
+bool BuildMeshCullData(const Triangle *tris, int triCount, MeshCullData *out);
+void FreeMeshCullData(MeshCullData *data);
+
+// ==== Per-frame tests ====
+
+// Side and behind-camera planes of the view volume in model space (xyz.p + w >= 0 is inside).
+// There is no far plane since the rasterizer does not clip against it.
+#define FRUSTUM_PLANE_COUNT 5
+void ExtractFrustumPlanes(Mat4 mvp, Vec4 planes[FRUSTUM_PLANE_COUNT]);
+
+// False only if every triangle in the meshlet is outside the frustum or back-facing
+bool MeshletVisible(const Meshlet *meshlet, const Vec4 planes[FRUSTUM_PLANE_COUNT], Vec3 camModel);
+
+// Same test renderLoop used to do per frame, against the precomputed plane
+static inline bool TriangleFrontFacing(Vec4 facePlane, Vec3 camModel) {
+    return facePlane.x * camModel.x + facePlane.y * camModel.y + facePlane.z * camModel.z >= facePlane.w;
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "msaa.h"
+
+// Standard 4x rotated grid (in 1/16 pixel units: -2,-6  6,-2  -6,2  2,6)
+const Vec2 MSAA_SAMPLE_OFFSETS[MSAA_SAMPLES] = {
+    { -0.125f, -0.375f },
+    {  0.375f, -0.125f },
+    { -0.375f,  0.125f },
+    {  0.125f,  0.375f },
+};
+
+bool MsaaInit(MsaaBuffer *buffer, int width, int height) {
+    memset(buffer, 0, sizeof(MsaaBuffer));
+    size_t pixels = (size_t)width * height;
+
+    buffer->width = width;
+    buffer->height = height;
+    buffer->depth = malloc(sizeof(float) * pixels);
+    buffer->colour = malloc(sizeof(uint32_t) * pixels);
+    buffer->meta = malloc(sizeof(uint32_t) * pixels);
+    // The flat entry plus one per pixel, and room for the next triangle's
+    buffer->slopeCapacity = (int)pixels + 2;
+    buffer->slopes = malloc(sizeof(Vec2) * buffer->slopeCapacity);
+    buffer->slopeRemap = malloc(sizeof(uint32_t) * buffer->slopeCapacity);
+    buffer->blocks = malloc(sizeof(MsaaSampleBlock) * pixels);
+
+    if (!buffer->depth || !buffer->colour || !buffer->meta || !buffer->slopes || !buffer->slopeRemap ||
+            !buffer->blocks) {
+        fprintf(stderr, "Failed to allocate %dx%d MSAA buffer\n", width, height);
+        MsaaDestroy(buffer);
+        return false;
+    }
+
+    MsaaClear(buffer);
+    return true;
+}
+
+void MsaaDestroy(MsaaBuffer *buffer) {
+    free(buffer->depth);
+    free(buffer->colour);
+    free(buffer->meta);
+    free(buffer->slopes);
+    free(buffer->slopeRemap);
+    free(buffer->blocks);
+    memset(buffer, 0, sizeof(MsaaBuffer));
+}
+
+void MsaaClear(MsaaBuffer *buffer) {
+    int totalPixels = buffer->width * buffer->height;
+    for (int i = 0; i < totalPixels; i++) {
+        buffer->depth[i] = -INFINITY;
+    }
+    memset(buffer->colour, 0, sizeof(uint32_t) * totalPixels);
+    memset(buffer->meta, 0, sizeof(uint32_t) * totalPixels);
+
+    buffer->slopes[0] = (Vec2){ 0.0f, 0.0f };
+    buffer->slopeCount = 1;
+    buffer->blockCount = 0;
+}
+
+// Drops the slopes no compressed pixel refers to any more (their pixels were
+// overwritten or expanded), keeping the order of the rest so they can move down in place
+static void CompactSlopes(MsaaBuffer *buffer) {
+    uint32_t *remap = buffer->slopeRemap;
+    memset(remap, 0, sizeof(uint32_t) * buffer->slopeCount);
+    remap[0] = 1;
+
+    int totalPixels = buffer->width * buffer->height;
+    for (int i = 0; i < totalPixels; i++) {
+        if (!(buffer->meta[i] & MSAA_EXPANDED)) remap[buffer->meta[i]] = 1;
+    }
+
+    int live = 0;
+    for (int i = 0; i < buffer->slopeCount; i++) {
+        if (!remap[i]) continue;
+        buffer->slopes[live] = buffer->slopes[i];
+        remap[i] = (uint32_t)live++;
+    }
+    buffer->slopeCount = live;
+
+    for (int i = 0; i < totalPixels; i++) {
+        if (!(buffer->meta[i] & MSAA_EXPANDED)) buffer->meta[i] = remap[buffer->meta[i]];
+    }
+}
+
+uint32_t MsaaAddSlopes(MsaaBuffer *buffer, float dzdx, float dzdy) {
+    // Overdraw registers more slopes than there are pixels, but at most one per
+    // pixel is still in use, so compacting always frees an entry
+    if (buffer->slopeCount == buffer->slopeCapacity) CompactSlopes(buffer);
+
+    buffer->slopes[buffer->slopeCount] = (Vec2){ dzdx, dzdy };
+    return (uint32_t)buffer->slopeCount++;
+}
+
+MsaaSampleBlock* MsaaExpandPixel(MsaaBuffer *buffer, int pixelIndex) {
+    uint32_t meta = buffer->meta[pixelIndex];
+    if (meta & MSAA_EXPANDED) return &buffer->blocks[meta & ~MSAA_EXPANDED];
+
+    int blockIndex = buffer->blockCount++;
+    MsaaSampleBlock *block = &buffer->blocks[blockIndex];
+    Vec2 slope = buffer->slopes[meta];
+    float centre = buffer->depth[pixelIndex];
+
+    for (int s = 0; s < MSAA_SAMPLES; s++) {
+        block->depth[s] = centre + slope.x * MSAA_SAMPLE_OFFSETS[s].x + slope.y * MSAA_SAMPLE_OFFSETS[s].y;
+        block->colour[s] = buffer->colour[pixelIndex];
+    }
+
+    buffer->meta[pixelIndex] = MSAA_EXPANDED | (uint32_t)blockIndex;
+    return block;
+}
+
+void MsaaResolve(const MsaaBuffer *buffer, uint32_t *pixelBuffer, int pixelPitch, float *zbuffer) {
+    for (int y = 0; y < buffer->height; y++) {
+        uint32_t *pixelRow = pixelBuffer + y * pixelPitch;
+        for (int x = 0; x < buffer->width; x++) {
+            int i = y * buffer->width + x;
+            uint32_t meta = buffer->meta[i];
+            if (!(meta & MSAA_EXPANDED)) {
+                pixelRow[x] = buffer->colour[i];
+                if (zbuffer) zbuffer[i] = buffer->depth[i];
+                continue;
+            }
+
+            // Box filter the colour channels, rounding to nearest. Alpha is written
+            // opaque, as PackColour does for the geometry covering the edge, rather
+            // than averaged with the cleared (zero alpha) background samples.
+            const MsaaSampleBlock *block = &buffer->blocks[meta & ~MSAA_EXPANDED];
+            uint32_t r = 0, g = 0, b = 0;
+            float nearest = -INFINITY;
+            for (int s = 0; s < MSAA_SAMPLES; s++) {
+                uint32_t c = block->colour[s];
+                r += (c >> 16) & 0xFF;
+                g += (c >> 8) & 0xFF;
+                b += c & 0xFF;
+                nearest = fmaxf(nearest, block->depth[s]);
+            }
+
+            const uint32_t half = MSAA_SAMPLES / 2;
+            pixelRow[x] = 0xFF000000u | (((r + half) / MSAA_SAMPLES) << 16) |
+                          (((g + half) / MSAA_SAMPLES) << 8) | ((b + half) / MSAA_SAMPLES);
+            if (zbuffer) zbuffer[i] = nearest;
+        }
+    }
+}
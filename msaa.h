@@ -0,0 +1,73 @@
+#ifndef MSAA_H
+#define MSAA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "calcs.h"
+
+// ==== 4x multi-sample buffer ====
+// Coverage and depth are tracked per sample, colour is shaded once per pixel.
+// A pixel fully covered by one triangle stays compressed: a single colour, the
+// depth at the pixel centre and an index into a per-frame table of depth
+// slopes, from which the sample depths are rebuilt. Only pixels that end up
+// with samples from more than one triangle (edges) are expanded into a block
+// of per-sample colour and depth, so traffic only grows there.
+//
+// Footprint is not reduced: everything is reserved for the worst case in
+// MsaaInit so a frame never allocates. That is a 32 byte sample block and a
+// 12 byte slope entry (slope plus compaction remap) per pixel, on top of the
+// 12 bytes of compressed depth, colour and meta.
+
+#define MSAA_SAMPLES 4
+#define MSAA_FULL_MASK ((1u << MSAA_SAMPLES) - 1)
+#define MSAA_EXPANDED 0x80000000u // Set in meta when the pixel points at a sample block
+
+// Rotated grid sample positions, relative to the pixel centre
+extern const Vec2 MSAA_SAMPLE_OFFSETS[MSAA_SAMPLES];
+
+typedef struct {
+    float depth[MSAA_SAMPLES];
+    uint32_t colour[MSAA_SAMPLES];
+} MsaaSampleBlock;
+
+typedef struct {
+    int width;
+    int height;
+
+    // Compressed pixels
+    float *depth;     // Depth at the pixel centre
+    uint32_t *colour;
+    uint32_t *meta;   // Depth slope index, or MSAA_EXPANDED | sample block index
+
+    // Depth slopes (d/dx, d/dy) of each triangle that wrote a compressed pixel
+    // this frame. Entry 0 is flat and used by cleared pixels. Compacted through
+    // slopeRemap when full.
+    Vec2 *slopes;
+    uint32_t *slopeRemap;
+    int slopeCount;
+    int slopeCapacity;
+
+    // One block per expanded pixel at most, so this never runs out. Pixels
+    // stay expanded until the next clear.
+    MsaaSampleBlock *blocks;
+    int blockCount;
+} MsaaBuffer;
+
+bool MsaaInit(MsaaBuffer *buffer, int width, int height);
+void MsaaDestroy(MsaaBuffer *buffer);
+
+// Resets every pixel to compressed black at -infinity depth
+void MsaaClear(MsaaBuffer *buffer);
+
+// Registers a triangle's depth slopes and returns their index. Drops the
+// entries no pixel refers to any more when the table is full, so it never fails.
+uint32_t MsaaAddSlopes(MsaaBuffer *buffer, float dzdx, float dzdy);
+
+// Converts a compressed pixel into a sample block and returns it
+MsaaSampleBlock* MsaaExpandPixel(MsaaBuffer *buffer, int pixelIndex);
+
+// Averages the samples of each pixel into pixelBuffer (pixelPitch pixels per
+// row) and writes the nearest sample depth to zbuffer (which may be NULL)
+void MsaaResolve(const MsaaBuffer *buffer, uint32_t *pixelBuffer, int pixelPitch, float *zbuffer);
+
+#endif
@@ -0,0 +1,359 @@
+#define _POSIX_C_SOURCE 200809L
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "pageFile.h"
+#include "ImportObj.h"
+
+// Aim for half-full pages on average so most cells fit in a single page
+#define CELL_TARGET_TRIS (PAGE_MAX_TRIS / 2)
+// Caps the per-cell bookkeeping, the only builder memory that scales with the scene
+#define MAX_GRID_CELLS (1 << 22)
+
+typedef struct {
+    Vec3 origin;
+    float cellSize;
+    int dims[3];
+} PageGrid;
+
+static void ChooseGrid(Vec3 boundsMin, Vec3 boundsMax, uint64_t triCount, PageGrid *grid) {
+    uint64_t cellsWanted = triCount / CELL_TARGET_TRIS;
+    if (cellsWanted < 1) cellsWanted = 1;
+    if (cellsWanted > MAX_GRID_CELLS) cellsWanted = MAX_GRID_CELLS;
+
+    Vec3 extent = vec3_sub(boundsMax, boundsMin);
+    float largest = fmaxf(extent.x, fmaxf(extent.y, extent.z));
+    float minExtent = largest * 1e-3f + 1e-6f; // Keep flat scenes from collapsing the volume
+    float ex = fmaxf(extent.x, minExtent);
+    float ey = fmaxf(extent.y, minExtent);
+    float ez = fmaxf(extent.z, minExtent);
+
+    // Size cells for the axes that actually get split; a thin axis (terrain,
+    // a building floor) stays one cell thick and must not eat into the count
+    float ext[3] = { ex, ey, ez };
+    bool split[3] = { true, true, true };
+    for (int pass = 0; pass < 3; pass++) {
+        float volume = 1.0f;
+        int axes = 0;
+        for (int k = 0; k < 3; k++) {
+            if (!split[k]) continue;
+            volume *= ext[k];
+            axes++;
+        }
+        grid->cellSize = powf(volume / (float)cellsWanted, 1.0f / (float)axes);
+
+        bool changed = false;
+        for (int k = 0; k < 3; k++) {
+            if (split[k] && ext[k] <= grid->cellSize && axes > 1) {
+                split[k] = false;
+                axes--;
+                changed = true;
+            }
+        }
+        if (!changed) break;
+    }
+
+    grid->origin = boundsMin;
+    for (;;) {
+        grid->dims[0] = (int)fmaxf(1.0f, ceilf(ex / grid->cellSize));
+        grid->dims[1] = (int)fmaxf(1.0f, ceilf(ey / grid->cellSize));
+        grid->dims[2] = (int)fmaxf(1.0f, ceilf(ez / grid->cellSize));
+        if ((uint64_t)grid->dims[0] * grid->dims[1] * grid->dims[2] <= MAX_GRID_CELLS) break;
+        grid->cellSize *= 1.25f;
+    }
+}
+
+static uint32_t GridCell(const PageGrid *grid, Vec3 p) {
+    int c[3];
+    float local[3] = { p.x - grid->origin.x, p.y - grid->origin.y, p.z - grid->origin.z };
+    for (int k = 0; k < 3; k++) {
+        c[k] = (int)(local[k] / grid->cellSize);
+        if (c[k] < 0) c[k] = 0;
+        if (c[k] >= grid->dims[k]) c[k] = grid->dims[k] - 1;
+    }
+    return (uint32_t)((c[2] * grid->dims[1] + c[1]) * grid->dims[0] + c[0]);
+}
+
+static Vec3 TriangleCentroid(const Triangle *tri) {
+    return vec3_scale(vec3_add(vec3_add(tri->v0.pos, tri->v1.pos), tri->v2.pos), 1.0f / 3.0f);
+}
+
+typedef void (*ObjTriangleFn)(void *ctx, const Triangle *tri);
+
+// Streams the faces of an OBJ through fn, resolving indices with the mapped
+// vertex array. Mirrors LoadObjTriangles: faces referring to vertices not yet
+// seen are skipped and counted in skippedFaces, and a read error fails the pass.
+static bool ForEachObjTriangle(const char *objPath, const Vec3 *verts, ObjTriangleFn fn, void *ctx,
+        uint64_t *skippedFaces) {
+    FILE *file = fopen(objPath, "r");
+    if (!file) {
+        fprintf(stderr, "Failed to open OBJ file: %s\n", objPath);
+        return false;
+    }
+
+    long long vertsSeen = 0;
+    *skippedFaces = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        Vec3 v;
+        int i0, i1, i2;
+        if (ParseObjVertex(line, &v)) {
+            vertsSeen++;
+        } else if (ParseObjFace(line, &i0, &i1, &i2)) {
+            if (i0 <= 0 || i1 <= 0 || i2 <= 0 || i0 > vertsSeen || i1 > vertsSeen || i2 > vertsSeen) {
+                (*skippedFaces)++;
+                continue;
+            }
+            Triangle tri = MakeObjTriangle(verts[i0 - 1], verts[i1 - 1], verts[i2 - 1]);
+            fn(ctx, &tri);
+        }
+    }
+
+    // A short pass would leave cells partly filled, so it must not pass for EOF
+    bool readError = ferror(file);
+    fclose(file);
+    if (readError) {
+        fprintf(stderr, "Failed to read OBJ file: %s\n", objPath);
+        return false;
+    }
+    return true;
+}
+
+typedef struct {
+    const PageGrid *grid;
+    uint64_t *cellCounts;
+    uint64_t *cellCursor;  // Next triangle slot per cell, in file order
+    Triangle *data;        // Mapped triangle region of the output
+    uint64_t triangleCount;
+} PageBuildState;
+
+static void CountTriangle(void *ctx, const Triangle *tri) {
+    PageBuildState *state = ctx;
+    state->cellCounts[GridCell(state->grid, TriangleCentroid(tri))]++;
+    state->triangleCount++;
+}
+
+static void ScatterTriangle(void *ctx, const Triangle *tri) {
+    PageBuildState *state = ctx;
+    uint32_t cell = GridCell(state->grid, TriangleCentroid(tri));
+    state->data[state->cellCursor[cell]++] = *tri;
+}
+
+// Pass 1: spill vertices to a flat binary file and gather bounds and a face count
+static bool SpillVertices(const char *objPath, const char *vertPath, Vec3 *boundsMin, Vec3 *boundsMax,
+        uint64_t *vertCount, uint64_t *faceCount) {
+    FILE *in = fopen(objPath, "r");
+    if (!in) {
+        fprintf(stderr, "Failed to open OBJ file: %s\n", objPath);
+        return false;
+    }
+    FILE *out = fopen(vertPath, "wb");
+    if (!out) {
+        fprintf(stderr, "Failed to create %s\n", vertPath);
+        fclose(in);
+        return false;
+    }
+
+    *vertCount = 0;
+    *faceCount = 0;
+    *boundsMin = (Vec3){ INFINITY, INFINITY, INFINITY };
+    *boundsMax = (Vec3){ -INFINITY, -INFINITY, -INFINITY };
+
+    char line[512];
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), in)) {
+        Vec3 v;
+        if (ParseObjVertex(line, &v)) {
+            ok = fwrite(&v, sizeof(Vec3), 1, out) == 1;
+            boundsMin->x = fminf(boundsMin->x, v.x); boundsMax->x = fmaxf(boundsMax->x, v.x);
+            boundsMin->y = fminf(boundsMin->y, v.y); boundsMax->y = fmaxf(boundsMax->y, v.y);
+            boundsMin->z = fminf(boundsMin->z, v.z); boundsMax->z = fmaxf(boundsMax->z, v.z);
+            (*vertCount)++;
+        } else if (line[0] == 'f' && line[1] == ' ') {
+            (*faceCount)++;
+        }
+    }
+
+    bool readError = ferror(in);
+    fclose(in);
+    if (fclose(out) != 0) ok = false;
+    if (readError) fprintf(stderr, "Failed to read OBJ file: %s\n", objPath);
+    if (!ok) fprintf(stderr, "Failed writing vertex spill file %s\n", vertPath);
+    return ok && !readError;
+}
+
+bool BuildPageFile(const char *objPath, const char *pagePath) {
+    char vertPath[1024];
+    snprintf(vertPath, sizeof(vertPath), "%s.verts.tmp", pagePath);
+
+    Vec3 boundsMin, boundsMax;
+    uint64_t vertCount, faceCount;
+    if (!SpillVertices(objPath, vertPath, &boundsMin, &boundsMax, &vertCount, &faceCount)) {
+        remove(vertPath);
+        return false;
+    }
+    if (vertCount == 0 || faceCount == 0) {
+        fprintf(stderr, "No geometry found in %s\n", objPath);
+        remove(vertPath);
+        return false;
+    }
+
+    // Map the spilled vertices so face lookups page them in on demand
+    int vertFd = open(vertPath, O_RDONLY);
+    size_t vertBytes = (size_t)vertCount * sizeof(Vec3);
+    Vec3 *verts = vertFd >= 0 ? mmap(NULL, vertBytes, PROT_READ, MAP_SHARED, vertFd, 0) : MAP_FAILED;
+    if (verts == MAP_FAILED) {
+        fprintf(stderr, "Failed to map %s\n", vertPath);
+        if (vertFd >= 0) close(vertFd);
+        remove(vertPath);
+        return false;
+    }
+
+    PageGrid grid;
+    ChooseGrid(boundsMin, boundsMax, faceCount, &grid);
+    size_t cellCount = (size_t)grid.dims[0] * grid.dims[1] * grid.dims[2];
+
+    PageBuildState state = { .grid = &grid };
+    state.cellCounts = calloc(cellCount, sizeof(uint64_t));
+    state.cellCursor = calloc(cellCount, sizeof(uint64_t));
+
+    bool ok = state.cellCounts && state.cellCursor;
+
+    // Pass 2: count triangles per cell
+    uint64_t skippedFaces = 0;
+    ok = ok && ForEachObjTriangle(objPath, verts, CountTriangle, &state, &skippedFaces);
+    ok = ok && state.triangleCount > 0;
+    if (ok && skippedFaces > 0) {
+        fprintf(stderr, "Skipped %llu faces with missing or out of range vertex indices in %s\n",
+            (unsigned long long)skippedFaces, objPath);
+    }
+
+    // Lay cells out back to back, each split into pages of PAGE_MAX_TRIS
+    uint64_t pageCount = 0;
+    uint64_t triStart = 0;
+    if (ok) {
+        for (size_t c = 0; c < cellCount; c++) {
+            state.cellCursor[c] = triStart;
+            triStart += state.cellCounts[c];
+            pageCount += (state.cellCounts[c] + PAGE_MAX_TRIS - 1) / PAGE_MAX_TRIS;
+        }
+    }
+
+    uint64_t indexOffset = sizeof(PageFileHeader);
+    uint64_t dataOffset = indexOffset + pageCount * sizeof(PageInfo);
+    uint64_t fileSize = dataOffset + state.triangleCount * sizeof(Triangle);
+
+    int outFd = -1;
+    unsigned char *out = MAP_FAILED;
+    if (ok) {
+        outFd = open(pagePath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        ok = outFd >= 0 && ftruncate(outFd, (off_t)fileSize) == 0;
+        if (ok) out = mmap(NULL, (size_t)fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, outFd, 0);
+        ok = ok && out != MAP_FAILED;
+        if (!ok) fprintf(stderr, "Failed to create page file %s\n", pagePath);
+    }
+
+    // Pass 3: scatter triangles into their cell's slots in the mapped output
+    if (ok) {
+        state.data = (Triangle *)(out + dataOffset);
+        ok = ForEachObjTriangle(objPath, verts, ScatterTriangle, &state, &skippedFaces);
+    }
+
+    // Page index: split each cell into pages and compute tight bounds
+    if (ok) {
+        PageInfo *pages = (PageInfo *)(out + indexOffset);
+        uint64_t page = 0;
+        uint64_t cellStart = 0;
+        for (size_t c = 0; c < cellCount; c++) {
+            for (uint64_t first = 0; first < state.cellCounts[c]; first += PAGE_MAX_TRIS) {
+                PageInfo *info = &pages[page++];
+                uint64_t count = state.cellCounts[c] - first;
+                if (count > PAGE_MAX_TRIS) count = PAGE_MAX_TRIS;
+
+                const Triangle *tris = &state.data[cellStart + first];
+                info->firstTriangle = cellStart + first;
+                info->triCount = (uint32_t)count;
+                info->dataOffset = dataOffset + info->firstTriangle * sizeof(Triangle);
+                info->reserved = 0;
+                info->boundsMin = info->boundsMax = tris[0].v0.pos;
+                for (uint64_t i = 0; i < count; i++) {
+                    const Vec3 corners[3] = { tris[i].v0.pos, tris[i].v1.pos, tris[i].v2.pos };
+                    for (int k = 0; k < 3; k++) {
+                        info->boundsMin.x = fminf(info->boundsMin.x, corners[k].x);
+                        info->boundsMin.y = fminf(info->boundsMin.y, corners[k].y);
+                        info->boundsMin.z = fminf(info->boundsMin.z, corners[k].z);
+                        info->boundsMax.x = fmaxf(info->boundsMax.x, corners[k].x);
+                        info->boundsMax.y = fmaxf(info->boundsMax.y, corners[k].y);
+                        info->boundsMax.z = fmaxf(info->boundsMax.z, corners[k].z);
+                    }
+                }
+            }
+            cellStart += state.cellCounts[c];
+        }
+
+        PageFileHeader header = {
+            .magic = PAGE_FILE_MAGIC,
+            .version = PAGE_FILE_VERSION,
+            .pageCount = (uint32_t)pageCount,
+            .maxPageTris = PAGE_MAX_TRIS,
+            .triangleCount = state.triangleCount,
+            .boundsMin = boundsMin,
+            .boundsMax = boundsMax
+        };
+        memcpy(out, &header, sizeof(header));
+
+        ok = msync(out, (size_t)fileSize, MS_SYNC) == 0;
+        printf("Paged %llu triangles into %llu pages (%dx%dx%d grid)\n",
+                (unsigned long long)state.triangleCount, (unsigned long long)pageCount,
+                grid.dims[0], grid.dims[1], grid.dims[2]);
+    }
+
+    if (out != MAP_FAILED) munmap(out, (size_t)fileSize);
+    if (outFd >= 0) close(outFd);
+    if (!ok) remove(pagePath);
+
+    munmap(verts, vertBytes);
+    close(vertFd);
+    remove(vertPath);
+    free(state.cellCounts);
+    free(state.cellCursor);
+    return ok;
+}
+
+bool ReadPageIndex(const char *pagePath, PageFileHeader *header, PageInfo **pages) {
+    *pages = NULL;
+
+    FILE *file = fopen(pagePath, "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to open page file: %s\n", pagePath);
+        return false;
+    }
+
+    if (fread(header, sizeof(*header), 1, file) != 1
+        || header->magic != PAGE_FILE_MAGIC || header->version != PAGE_FILE_VERSION
+        || header->maxPageTris != PAGE_MAX_TRIS || header->pageCount == 0) {
+        fprintf(stderr, "Not a compatible page file: %s\n", pagePath);
+        fclose(file);
+        return false;
+    }
+
+    *pages = malloc(sizeof(PageInfo) * header->pageCount);
+    if (!*pages || fread(*pages, sizeof(PageInfo), header->pageCount, file) != header->pageCount) {
+        fprintf(stderr, "Failed to read page index from %s\n", pagePath);
+        free(*pages);
+        *pages = NULL;
+        fclose(file);
+        return false;
+    }
+
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef PAGE_FILE_H
+#define PAGE_FILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "calcs.h"
+
+// ==== Paged geometry file ====
+// Out-of-core layout for scenes too large to load whole. Triangles are
+// bucketed into a uniform grid by centroid and each cell is split into pages
+// of at most PAGE_MAX_TRIS triangles, stored contiguously:
+//
+//   PageFileHeader | PageInfo[pageCount] | Triangle data
+//
+// All values are little-endian, as written by the host.
+
+#define PAGE_FILE_MAGIC   0x47504352u // "CRPG"
+#define PAGE_FILE_VERSION 1
+#define PAGE_MAX_TRIS     4096
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t pageCount;
+    uint32_t maxPageTris;
+    uint64_t triangleCount;
+    Vec3 boundsMin;
+    Vec3 boundsMax;
+} PageFileHeader;
+
+typedef struct {
+    Vec3 boundsMin;
+    Vec3 boundsMax;
+    uint64_t dataOffset;     // Byte offset of the first triangle in the file
+    uint64_t firstTriangle;  // Global id of the first triangle, for stable colours
+    uint32_t triCount;
+    uint32_t reserved;
+} PageInfo;
+
+// Converts an OBJ into a page file using bounded memory: vertices are spilled
+// to a temporary file and both it and the output are memory mapped, so RAM
+// use stays proportional to the grid size rather than the scene size.
+bool BuildPageFile(const char *objPath, const char *pagePath);
+
+// Reads the header and page index. pages is malloc'd, caller must free.
+bool ReadPageIndex(const char *pagePath, PageFileHeader *header, PageInfo **pages);
+
+#endif
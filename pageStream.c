@@ -0,0 +1,377 @@
+#define _POSIX_C_SOURCE 200809L
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <SDL3/SDL.h>
+
+#include "pageStream.h"
+#include "raster.h"
+#include "meshlet.h"
+
+// Never fewer slots than this, whatever the budget
+#define MIN_SLOTS 8
+// Bounds how much loading a single frame can queue up
+#define MAX_REQUESTS_PER_FRAME 64
+// How far ahead of the camera prefetching looks
+#define PREFETCH_SECONDS 0.5f
+
+enum {
+    PAGE_EVICTED,
+    PAGE_LOADING,
+    PAGE_RESIDENT,
+    PAGE_FAILED     // Read failed; the page is never requested again and holds no slot
+};
+
+typedef struct {
+    int page;
+    int slot;
+} PageRequest;
+
+typedef struct {
+    float distance;
+    int page;
+} PageDistance;
+
+struct PageStream {
+    int fd;
+    PageFileHeader header;
+    PageInfo *pages;
+    SDL_AtomicInt *pageState;  // Written by the loader once a read finishes
+    int *pageSlot;             // -1 when the page has no slot
+
+    // Fixed pool of page sized slots, owned by the main thread
+    int slotCount;
+    Triangle *slotData;
+    int *slotPage;
+    uint64_t *slotLastUsed;
+    int *freeSlots;
+    int freeCount;
+    uint64_t frame;
+
+    // Request ring, at most one entry per slot
+    SDL_Thread *loader;
+    SDL_Mutex *lock;
+    SDL_Condition *wake;
+    PageRequest *queue;
+    int queueHead;
+    int queueCount;
+    bool quit;
+    SDL_AtomicInt pendingLoads;
+    SDL_AtomicInt loadsDone;
+
+    // Per-update scratch sized from the page count once at open, so the
+    // index size never depends on a per-frame allocator
+    int *visible;              // Visible pages from the last update
+    int visibleCount;
+    PageDistance *order;       // Load candidates being sorted by distance
+    int drawnPages;
+};
+
+static bool ReadFully(int fd, void *dst, size_t size, uint64_t offset) {
+    char *out = dst;
+    while (size > 0) {
+        ssize_t got = pread(fd, out, size, (off_t)offset);
+        if (got <= 0) return false;
+        out += got;
+        size -= (size_t)got;
+        offset += (uint64_t)got;
+    }
+    return true;
+}
+
+static int SDLCALL PageLoaderThread(void *data) {
+    PageStream *stream = data;
+
+    for (;;) {
+        SDL_LockMutex(stream->lock);
+        while (stream->queueCount == 0 && !stream->quit) {
+            SDL_WaitCondition(stream->wake, stream->lock);
+        }
+        if (stream->quit) {
+            SDL_UnlockMutex(stream->lock);
+            break;
+        }
+        PageRequest req = stream->queue[stream->queueHead];
+        stream->queueHead = (stream->queueHead + 1) % stream->slotCount;
+        stream->queueCount--;
+        SDL_UnlockMutex(stream->lock);
+
+        // The main thread never reuses a LOADING slot, so it is safe to fill unlocked
+        const PageInfo *info = &stream->pages[req.page];
+        Triangle *dst = stream->slotData + (size_t)req.slot * PAGE_MAX_TRIS;
+        bool ok = ReadFully(stream->fd, dst, sizeof(Triangle) * info->triCount, info->dataOffset);
+        if (!ok) {
+            fprintf(stderr, "Failed to read page %d\n", req.page);
+        }
+
+        SDL_SetAtomicInt(&stream->pageState[req.page], ok ? PAGE_RESIDENT : PAGE_FAILED);
+        SDL_AddAtomicInt(&stream->pendingLoads, -1);
+        SDL_AddAtomicInt(&stream->loadsDone, 1);
+    }
+
+    return 0;
+}
+
+PageStream* OpenPageStream(const char *pagePath, size_t budgetBytes) {
+    PageStream *stream = calloc(1, sizeof(PageStream));
+    if (!stream) {
+        fprintf(stderr, "Failed to allocate page stream\n");
+        return NULL;
+    }
+    stream->fd = -1;
+
+    if (!ReadPageIndex(pagePath, &stream->header, &stream->pages)) {
+        free(stream);
+        return NULL;
+    }
+
+    stream->fd = open(pagePath, O_RDONLY);
+    if (stream->fd < 0) {
+        fprintf(stderr, "Failed to open page file: %s\n", pagePath);
+        ClosePageStream(stream);
+        return NULL;
+    }
+
+    int pageCount = (int)stream->header.pageCount;
+    size_t slotBytes = sizeof(Triangle) * PAGE_MAX_TRIS;
+    size_t slots = budgetBytes / slotBytes;
+    if (slots < MIN_SLOTS) slots = MIN_SLOTS;
+    if (slots > (size_t)pageCount) slots = pageCount > 0 ? (size_t)pageCount : 1;
+    stream->slotCount = (int)slots;
+
+    stream->pageState = calloc(pageCount > 0 ? pageCount : 1, sizeof(SDL_AtomicInt));
+    stream->pageSlot = malloc(sizeof(int) * (pageCount > 0 ? pageCount : 1));
+    stream->slotData = malloc(slotBytes * slots);
+    stream->slotPage = malloc(sizeof(int) * slots);
+    stream->slotLastUsed = calloc(slots, sizeof(uint64_t));
+    stream->freeSlots = malloc(sizeof(int) * slots);
+    stream->queue = malloc(sizeof(PageRequest) * slots);
+    stream->visible = malloc(sizeof(int) * (pageCount > 0 ? pageCount : 1));
+    stream->order = malloc(sizeof(PageDistance) * (pageCount > 0 ? pageCount : 1));
+    stream->lock = SDL_CreateMutex();
+    stream->wake = SDL_CreateCondition();
+
+    if (!stream->pageState || !stream->pageSlot || !stream->slotData || !stream->slotPage ||
+            !stream->slotLastUsed || !stream->freeSlots || !stream->queue || !stream->visible ||
+            !stream->order || !stream->lock || !stream->wake) {
+        fprintf(stderr, "Failed to allocate page cache (%zu slots)\n", slots);
+        ClosePageStream(stream);
+        return NULL;
+    }
+
+    for (int i = 0; i < pageCount; i++) stream->pageSlot[i] = -1;
+    for (int i = 0; i < stream->slotCount; i++) {
+        stream->slotPage[i] = -1;
+        stream->freeSlots[i] = stream->slotCount - 1 - i;
+    }
+    stream->freeCount = stream->slotCount;
+
+    stream->loader = SDL_CreateThread(PageLoaderThread, "PageLoader", stream);
+    if (!stream->loader) {
+        fprintf(stderr, "Failed to start page loader: %s\n", SDL_GetError());
+        ClosePageStream(stream);
+        return NULL;
+    }
+
+    printf("Streaming %d pages (%llu triangles), %d resident slots (%.1f MB)\n",
+        pageCount, (unsigned long long)stream->header.triangleCount, stream->slotCount,
+        (double)(slotBytes * slots) / (1024.0 * 1024.0));
+    return stream;
+}
+
+void ClosePageStream(PageStream *stream) {
+    if (!stream) return;
+
+    if (stream->loader) {
+        SDL_LockMutex(stream->lock);
+        stream->quit = true;
+        SDL_BroadcastCondition(stream->wake);
+        SDL_UnlockMutex(stream->lock);
+        SDL_WaitThread(stream->loader, NULL);
+    }
+
+    if (stream->wake) SDL_DestroyCondition(stream->wake);
+    if (stream->lock) SDL_DestroyMutex(stream->lock);
+    if (stream->fd >= 0) close(stream->fd);
+    free(stream->pages);
+    free(stream->pageState);
+    free(stream->pageSlot);
+    free(stream->slotData);
+    free(stream->slotPage);
+    free(stream->slotLastUsed);
+    free(stream->freeSlots);
+    free(stream->queue);
+    free(stream->visible);
+    free(stream->order);
+    free(stream);
+}
+
+// Conservative box test: rejects only when the corner furthest along a
+// plane's normal is still behind it
+static bool PageInFrustum(const PageInfo *page, const Vec4 planes[FRUSTUM_PLANE_COUNT]) {
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+        Vec4 p = planes[i];
+        float x = p.x >= 0.0f ? page->boundsMax.x : page->boundsMin.x;
+        float y = p.y >= 0.0f ? page->boundsMax.y : page->boundsMin.y;
+        float z = p.z >= 0.0f ? page->boundsMax.z : page->boundsMin.z;
+        if (p.x * x + p.y * y + p.z * z + p.w < 0.0f) return false;
+    }
+    return true;
+}
+
+static float PageDistanceSq(const PageInfo *page, Vec3 p) {
+    float dx = fmaxf(fmaxf(page->boundsMin.x - p.x, 0.0f), p.x - page->boundsMax.x);
+    float dy = fmaxf(fmaxf(page->boundsMin.y - p.y, 0.0f), p.y - page->boundsMax.y);
+    float dz = fmaxf(fmaxf(page->boundsMin.z - p.z, 0.0f), p.z - page->boundsMax.z);
+    return dx * dx + dy * dy + dz * dz;
+}
+
+static int ComparePageDistance(const void *a, const void *b) {
+    float da = ((const PageDistance *)a)->distance;
+    float db = ((const PageDistance *)b)->distance;
+    return (da > db) - (da < db);
+}
+
+// Picks a free slot, else the least recently used one that was not touched
+// this frame and is not mid-load. Returns -1 when everything is in use.
+static int AcquireSlot(PageStream *stream) {
+    if (stream->freeCount > 0) return stream->freeSlots[--stream->freeCount];
+
+    int best = -1;
+    for (int i = 0; i < stream->slotCount; i++) {
+        if (stream->slotLastUsed[i] >= stream->frame) continue;
+        if (SDL_GetAtomicInt(&stream->pageState[stream->slotPage[i]]) == PAGE_LOADING) continue;
+        if (best < 0 || stream->slotLastUsed[i] < stream->slotLastUsed[best]) best = i;
+    }
+
+    if (best >= 0) {
+        // A page whose read failed since the last update stays failed
+        int evicted = stream->slotPage[best];
+        stream->pageSlot[evicted] = -1;
+        if (SDL_GetAtomicInt(&stream->pageState[evicted]) == PAGE_RESIDENT) {
+            SDL_SetAtomicInt(&stream->pageState[evicted], PAGE_EVICTED);
+        }
+        stream->slotPage[best] = -1;
+    }
+    return best;
+}
+
+static bool RequestPage(PageStream *stream, int page) {
+    int slot = AcquireSlot(stream);
+    if (slot < 0) return false;
+
+    stream->slotPage[slot] = page;
+    stream->slotLastUsed[slot] = stream->frame;
+    stream->pageSlot[page] = slot;
+    SDL_SetAtomicInt(&stream->pageState[page], PAGE_LOADING);
+    SDL_AddAtomicInt(&stream->pendingLoads, 1);
+
+    SDL_LockMutex(stream->lock);
+    int tail = (stream->queueHead + stream->queueCount) % stream->slotCount;
+    stream->queue[tail] = (PageRequest){ page, slot };
+    stream->queueCount++;
+    SDL_SignalCondition(stream->wake);
+    SDL_UnlockMutex(stream->lock);
+    return true;
+}
+
+// Hands the slots of pages whose read failed back to the free list. Slots are
+// main thread state, so the loader only marks the page and this reclaims it.
+static void ReleaseFailedSlots(PageStream *stream) {
+    for (int i = 0; i < stream->slotCount; i++) {
+        int page = stream->slotPage[i];
+        if (page < 0 || SDL_GetAtomicInt(&stream->pageState[page]) != PAGE_FAILED) continue;
+
+        stream->pageSlot[page] = -1;
+        stream->slotPage[i] = -1;
+        stream->freeSlots[stream->freeCount++] = i;
+    }
+}
+
+void PageStreamUpdate(PageStream *stream, Mat4 mvp, Vec3 camPos, Vec3 camVelocity) {
+    int pageCount = (int)stream->header.pageCount;
+    PageDistance *order = stream->order;
+    stream->frame++;
+    stream->visibleCount = 0;
+    ReleaseFailedSlots(stream);
+
+    Vec4 planes[FRUSTUM_PLANE_COUNT];
+    ExtractFrustumPlanes(mvp, planes);
+
+    int missing = 0;
+    for (int i = 0; i < pageCount; i++) {
+        if (!PageInFrustum(&stream->pages[i], planes)) continue;
+        stream->visible[stream->visibleCount++] = i;
+
+        // Touch resident pages first so this frame's set is never evicted
+        int slot = stream->pageSlot[i];
+        if (slot >= 0) {
+            stream->slotLastUsed[slot] = stream->frame;
+        } else if (SDL_GetAtomicInt(&stream->pageState[i]) != PAGE_FAILED) {
+            order[missing++] = (PageDistance){ PageDistanceSq(&stream->pages[i], camPos), i };
+        }
+    }
+
+    // Nearest pages fill in first, they cover the most of the screen
+    qsort(order, missing, sizeof(PageDistance), ComparePageDistance);
+    int requests = 0;
+    for (int i = 0; i < missing && requests < MAX_REQUESTS_PER_FRAME; i++) {
+        if (!RequestPage(stream, order[i].page)) break;
+        requests++;
+    }
+
+    // Prefetch what the frustum will cover shortly if the camera keeps moving.
+    // Shifting the planes by -d is the same as moving the camera by d.
+    Vec3 ahead = vec3_scale(camVelocity, PREFETCH_SECONDS);
+    if (requests >= MAX_REQUESTS_PER_FRAME || vec3_dot(ahead, ahead) < 1e-8f) return;
+
+    Vec4 predicted[FRUSTUM_PLANE_COUNT];
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+        predicted[i] = planes[i];
+        predicted[i].w -= planes[i].x * ahead.x + planes[i].y * ahead.y + planes[i].z * ahead.z;
+    }
+    Vec3 predictedPos = vec3_add(camPos, ahead);
+
+    int prefetch = 0;
+    for (int i = 0; i < pageCount; i++) {
+        if (stream->pageSlot[i] >= 0 || SDL_GetAtomicInt(&stream->pageState[i]) == PAGE_FAILED) continue;
+        if (!PageInFrustum(&stream->pages[i], predicted)) continue;
+        order[prefetch++] = (PageDistance){ PageDistanceSq(&stream->pages[i], predictedPos), i };
+    }
+
+    qsort(order, prefetch, sizeof(PageDistance), ComparePageDistance);
+    for (int i = 0; i < prefetch && requests < MAX_REQUESTS_PER_FRAME; i++) {
+        if (!RequestPage(stream, order[i].page)) break;
+        requests++;
+    }
+}
+
+void PageStreamDraw(PageStream *stream, Mat4 mvp, Vec3 camPos, int window_height, int window_width,
+        float *zbuffer, uint32_t *pixelBuffer, int pixelPitch, MsaaBuffer *msaa) {
+    stream->drawnPages = 0;
+
+    for (int i = 0; i < stream->visibleCount; i++) {
+        int page = stream->visible[i];
+        if (SDL_GetAtomicInt(&stream->pageState[page]) != PAGE_RESIDENT) continue;
+
+        const PageInfo *info = &stream->pages[page];
+        const Triangle *tris = stream->slotData + (size_t)stream->pageSlot[page] * PAGE_MAX_TRIS;
+        RasterizeTriangles(tris, (int)info->triCount, info->firstTriangle, camPos, mvp,
+            window_height, window_width, zbuffer, pixelBuffer, pixelPitch, msaa, NULL);
+        stream->drawnPages++;
+    }
+}
+
+void PageStreamGetStats(PageStream *stream, PageStreamStats *stats) {
+    stats->pageCount = (int)stream->header.pageCount;
+    stats->slotCount = stream->slotCount;
+    stats->visiblePages = stream->visibleCount;
+    stats->drawnPages = stream->drawnPages;
+    stats->pendingLoads = SDL_GetAtomicInt(&stream->pendingLoads);
+    stats->loadsDone = (uint64_t)SDL_GetAtomicInt(&stream->loadsDone);
+}
@@ -0,0 +1,46 @@
+#ifndef PAGE_STREAM_H
+#define PAGE_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "calcs.h"
+#include "pageFile.h"
+#include "msaa.h"
+
+// ==== Streamed page cache ====
+// Keeps a fixed budget of pages from a page file resident. Each frame the
+// pages inside the frustum are requested nearest first, plus pages the camera
+// is moving towards; a background thread reads them in and the least recently
+// drawn pages are evicted to make room.
+
+typedef struct PageStream PageStream;
+
+typedef struct {
+    int pageCount;
+    int slotCount;        // Pages that fit in the budget
+    int visiblePages;     // Pages in the frustum this frame
+    int drawnPages;       // Visible pages that were resident and drawn
+    int pendingLoads;     // Requests the loader has not finished yet
+    uint64_t loadsDone;   // Total pages read since opening
+} PageStreamStats;
+
+// Opens a page file and starts the loader thread. budgetBytes bounds only the
+// resident triangle slots. The whole page index stays in memory next to them,
+// about 68 bytes per page (the 48 byte PageInfo, its state and slot, and the
+// per-update visible and sort scratch), so memory still grows with the page
+// count whatever the budget.
+PageStream* OpenPageStream(const char *pagePath, size_t budgetBytes);
+void ClosePageStream(PageStream *stream);
+
+// Culls pages against the frustum and queues loads for missing ones.
+// camVelocity (units per second) drives prefetching ahead of the camera.
+void PageStreamUpdate(PageStream *stream, Mat4 mvp, Vec3 camPos, Vec3 camVelocity);
+
+// Draws the resident pages found visible by the last PageStreamUpdate.
+// Buffers are not cleared, and an msaa buffer is not resolved.
+void PageStreamDraw(PageStream *stream, Mat4 mvp, Vec3 camPos, int window_height, int window_width,
+        float *zbuffer, uint32_t *pixelBuffer, int pixelPitch, MsaaBuffer *msaa);
+
+void PageStreamGetStats(PageStream *stream, PageStreamStats *stats);
+
+#endif
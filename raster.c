@@ -0,0 +1,525 @@
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+#include "raster.h"
+
+// Brightness of surfaces the light doesn't reach
+#define SHADOW_AMBIENT 0.3f
+
+// Depth bias in shadow map texels: a constant part, plus a part that grows
+// with the slope of the receiver as seen from the light (capped for grazing angles)
+#define SHADOW_BIAS_TEXELS 1.5f
+#define SHADOW_BIAS_SLOPE 1.5f
+#define SHADOW_BIAS_MAX_SLOPE 8.0f
+
+// Screen space setup shared by the single and multi-sample rasterizers
+typedef struct {
+    Vec2 s0, s1, s2;
+    int min_x, max_x, min_y, max_y;
+    float area;
+    float depth0, depth1, depth2;
+    float invW0, invW1, invW2;   // For perspective correct attributes
+} TriangleSetup;
+
+// Per-triangle state for shadowed shading
+typedef struct {
+    bool active;                 // False when the triangle is flat coloured
+    Vec3 light0, light1, light2; // Shadow map texel position and depth, divided by clip w
+    float bias;
+    uint32_t shadowed, lit;      // Packed colours with and without the light
+    Vec4 shadowedColour, litColour;
+} ShadowSetup;
+
+// Projects the triangle to the screen. False if it is behind the camera or degenerate.
+static bool SetupTriangle(Triangle tri, Mat4 mvp, int screen_width, int screen_height, TriangleSetup *ts) {
+    // Transform vertices to clip space
+    Vec4 p0 = mat4_mul_vec4(mvp, vec4_from_vec3(tri.v0.pos, 1.0f));
+    Vec4 p1 = mat4_mul_vec4(mvp, vec4_from_vec3(tri.v1.pos, 1.0f));
+    Vec4 p2 = mat4_mul_vec4(mvp, vec4_from_vec3(tri.v2.pos, 1.0f));
+
+    // Perform backface culling: skip any triangle if the vertex is behind the camera
+    if (p0.w >= 0.0f || p1.w >= 0.0f || p2.w >= 0.0f) return false;
+
+    ts->invW0 = 1.0f / p0.w;
+    ts->invW1 = 1.0f / p1.w;
+    ts->invW2 = 1.0f / p2.w;
+
+    // Perspective divide to get normalized device coordinates
+    p0 = vec4_scale(p0, 1.0f / p0.w);
+    p1 = vec4_scale(p1, 1.0f / p1.w);
+    p2 = vec4_scale(p2, 1.0f / p2.w);
+
+    // Convert normalized device coords to screen space
+    ts->s0 = (Vec2){ (p0.x + 1.0f) * 0.5f * screen_width, (1.0f - p0.y) * 0.5f * screen_height };
+    ts->s1 = (Vec2){ (p1.x + 1.0f) * 0.5f * screen_width, (1.0f - p1.y) * 0.5f * screen_height };
+    ts->s2 = (Vec2){ (p2.x + 1.0f) * 0.5f * screen_width, (1.0f - p2.y) * 0.5f * screen_height };
+    Vec2 s0 = ts->s0, s1 = ts->s1, s2 = ts->s2;
+
+    // Compute bounding box for triangle in screen space
+    ts->min_x = (int)fmaxf(0.0f, floorf(fminf(fminf(s0.x, s1.x), s2.x)));
+    ts->max_x = (int)fminf(screen_width - 1, ceilf(fmaxf(fmaxf(s0.x, s1.x), s2.x)));
+    ts->min_y = (int)fmaxf(0.0f, floorf(fminf(fminf(s0.y, s1.y), s2.y)));
+    ts->max_y = (int)fminf(screen_height - 1, ceilf(fmaxf(fmaxf(s0.y, s1.y), s2.y)));
+
+    // Calculate twice the area of the triangle for barycentric coords calculation
+    ts->area = (s1.x - s0.x) * (s2.y - s0.y) - (s1.y - s0.y) * (s2.x - s0.x);
+    if (ts->area == 0.0f) return false;
+
+    // Precompute depth values (in [0, 1])
+    ts->depth0 = (p0.z + 1.0f) * 0.5f;
+    ts->depth1 = (p1.z + 1.0f) * 0.5f;
+    ts->depth2 = (p2.z + 1.0f) * 0.5f;
+    return true;
+}
+
+// Pack ARGB colour into 32 bit integer
+static inline uint32_t PackColour(Vec4 colour) {
+    return ((uint32_t)(uint8_t)(colour.w * 255.0f) << 24) | // Alpha
+           ((uint32_t)(uint8_t)(colour.x * 255.0f) << 16) | // Red
+           ((uint32_t)(uint8_t)(colour.y * 255.0f) << 8)  | // Green
+           ((uint32_t)(uint8_t)(colour.z * 255.0f) << 0);   // Blue
+}
+
+static inline Vec4 ScaleColour(Vec4 colour, float s) {
+    return (Vec4){ colour.x * s, colour.y * s, colour.z * s, colour.w };
+}
+
+// Model space position to shadow map texel coordinates and [0, 1] depth
+static inline Vec3 LightTexel(const ShadowMap *map, Vec3 pos) {
+    const float (*m)[4] = map->lightMatrix.m;
+    float x = m[0][0] * pos.x + m[0][1] * pos.y + m[0][2] * pos.z + m[0][3];
+    float y = m[1][0] * pos.x + m[1][1] * pos.y + m[1][2] * pos.z + m[1][3];
+    float z = m[2][0] * pos.x + m[2][1] * pos.y + m[2][2] * pos.z + m[2][3];
+    return (Vec3){ (x + 1.0f) * 0.5f * map->size, (1.0f - y) * 0.5f * map->size, (z + 1.0f) * 0.5f };
+}
+
+// Lighting for one triangle. Faces turned away from the light are shadowed
+// outright and need no lookups.
+static ShadowSetup SetupShadow(Triangle tri, const TriangleSetup *ts, const ShadowMap *shadow, Vec4 colour) {
+    ShadowSetup ss = { 0 };
+    Vec3 normal = vec3_normalize(vec3_cross(vec3_sub(tri.v1.pos, tri.v0.pos), vec3_sub(tri.v2.pos, tri.v0.pos)));
+    float ndl = vec3_dot(normal, vec3_scale(shadow->lightDir, -1.0f));
+
+    ss.shadowedColour = ScaleColour(colour, SHADOW_AMBIENT);
+    ss.shadowed = PackColour(ss.shadowedColour);
+    if (!(ndl > 0.0f)) return ss;
+
+    ss.active = true;
+    ss.litColour = ScaleColour(colour, SHADOW_AMBIENT + (1.0f - SHADOW_AMBIENT) * ndl);
+    ss.lit = PackColour(ss.litColour);
+
+    ss.light0 = vec3_scale(LightTexel(shadow, tri.v0.pos), ts->invW0);
+    ss.light1 = vec3_scale(LightTexel(shadow, tri.v1.pos), ts->invW1);
+    ss.light2 = vec3_scale(LightTexel(shadow, tri.v2.pos), ts->invW2);
+
+    float slope = fminf(sqrtf(fmaxf(0.0f, 1.0f - ndl * ndl)) / ndl, SHADOW_BIAS_MAX_SLOPE);
+    ss.bias = shadow->texelWorld * (SHADOW_BIAS_TEXELS + SHADOW_BIAS_SLOPE * slope) / shadow->depthRange;
+    return ss;
+}
+
+// Colour of one pixel from its screen space barycentrics
+static inline uint32_t ShadePixel(const ShadowSetup *ss, const TriangleSetup *ts, const ShadowMap *shadow,
+        float w0, float w1, float w2) {
+    float w = 1.0f / (w0 * ts->invW0 + w1 * ts->invW1 + w2 * ts->invW2);
+    float u = (w0 * ss->light0.x + w1 * ss->light1.x + w2 * ss->light2.x) * w;
+    float v = (w0 * ss->light0.y + w1 * ss->light1.y + w2 * ss->light2.y) * w;
+    float d = (w0 * ss->light0.z + w1 * ss->light1.z + w2 * ss->light2.z) * w;
+
+    float lit = ShadowMapLit(shadow, u, v, d - ss->bias);
+    if (lit <= 0.0f) return ss->shadowed;
+    if (lit >= 1.0f) return ss->lit;
+
+    // Partly lit PCF footprint
+    Vec4 c = ss->shadowedColour;
+    Vec4 l = ss->litColour;
+    return PackColour((Vec4){ c.x + (l.x - c.x) * lit, c.y + (l.y - c.y) * lit, c.z + (l.z - c.z) * lit, c.w });
+}
+
+// Rasterizes a triangle on screen with depth buffering and colour
+void DrawTriangle(Triangle tri, Mat4 mvp, int screen_width, int screen_height, Vec4 colour, float *zbuffer,
+        uint32_t *pixelBuffer, int pixelPitch, const ShadowMap *shadow) {
+    TriangleSetup ts;
+    if (!SetupTriangle(tri, mvp, screen_width, screen_height, &ts)) return;
+
+    Vec2 s0 = ts.s0, s1 = ts.s1, s2 = ts.s2;
+    float area = ts.area;
+    float depth0 = ts.depth0, depth1 = ts.depth1, depth2 = ts.depth2;
+    int min_x = ts.min_x, max_x = ts.max_x, min_y = ts.min_y, max_y = ts.max_y;
+    uint32_t packed = PackColour(colour);
+
+    ShadowSetup ss = { 0 };
+    if (shadow) {
+        ss = SetupShadow(tri, &ts, shadow, colour);
+        packed = ss.shadowed;
+    }
+
+    // Loop over each pixel in the bounding box to rasterize the triangle
+    for (int y = min_y; y <= max_y; y++) {
+        float *zrow = zbuffer + y * screen_width; // Row pointer for zbuffer optimization
+        uint32_t *pixelRow = pixelBuffer + y * pixelPitch; // May be padded (locked textures)
+        for (int x = min_x; x <= max_x; x++) {
+
+            // Pixel center coordinates for barycentric calculation
+            float px = (float)x + 0.5f;
+            float py = (float)y + 0.5f;
+
+            // Compute barycentric coordinates for the pixel relative to the triangle
+            float w0 = ((s1.x - px)*(s2.y - py) - (s1.y - py)*(s2.x - px)) / area;
+            float w1 = ((s2.x - px)*(s0.y - py) - (s2.y - py)*(s0.x - px)) / area;
+            float w2 = 1.0f - w0 - w1;
+
+            // If the pixel lies inside the triangle
+            if (w0 >= 0.0f && w1 >= 0.0f && w2 >= 0.0f) {
+                // Interpolate depth at pixel using barycentric weights
+                float depth = w0 * depth0 + w1 * depth1 + w2 * depth2;
+
+                // Depth test update only if closer than current z value
+                if (depth > zrow[x]) {
+                    zrow[x] = depth; // Update our zbuffer with our depth
+                    pixelRow[x] = ss.active ? ShadePixel(&ss, &ts, shadow, w0, w1, w2) : packed;
+                }
+            }
+        }
+    }
+}
+
+// 4x MSAA variant: coverage and depth per sample, colour once per pixel
+void DrawTriangleMsaa(Triangle tri, Mat4 mvp, Vec4 colour, MsaaBuffer *target, const ShadowMap *shadow) {
+    TriangleSetup ts;
+    if (!SetupTriangle(tri, mvp, target->width, target->height, &ts)) return;
+
+    Vec2 s0 = ts.s0, s1 = ts.s1, s2 = ts.s2;
+    float area = ts.area;
+
+    // Flat shaded, so the colour is computed once and shared by every sample
+    uint32_t packed = PackColour(colour);
+
+    // Shadows are looked up once per pixel, at the centroid of its covered samples
+    ShadowSetup ss = { 0 };
+    if (shadow) {
+        ss = SetupShadow(tri, &ts, shadow, colour);
+        packed = ss.shadowed;
+    }
+
+    // Depth is affine in screen space; compressed pixels rebuild their samples from these
+    float dw0dx = (s1.y - s2.y) / area, dw0dy = (s2.x - s1.x) / area;
+    float dw1dx = (s2.y - s0.y) / area, dw1dy = (s0.x - s2.x) / area;
+    float dzdx = (ts.depth0 - ts.depth2) * dw0dx + (ts.depth1 - ts.depth2) * dw1dx;
+    float dzdy = (ts.depth0 - ts.depth2) * dw0dy + (ts.depth1 - ts.depth2) * dw1dy;
+    uint32_t slopeIndex = UINT32_MAX; // Registered on the first compressed write
+
+    // Barycentrics are affine too, so each sample is a fixed step from the pixel centre
+    // The largest step per edge bounds how far outside (or inside) the centre
+    // can be while still having samples on both sides
+    float sampleW0[MSAA_SAMPLES], sampleW1[MSAA_SAMPLES];
+    float reach0 = 0.0f, reach1 = 0.0f, reach2 = 0.0f;
+    for (int s = 0; s < MSAA_SAMPLES; s++) {
+        sampleW0[s] = dw0dx * MSAA_SAMPLE_OFFSETS[s].x + dw0dy * MSAA_SAMPLE_OFFSETS[s].y;
+        sampleW1[s] = dw1dx * MSAA_SAMPLE_OFFSETS[s].x + dw1dy * MSAA_SAMPLE_OFFSETS[s].y;
+        reach0 = fmaxf(reach0, fabsf(sampleW0[s]));
+        reach1 = fmaxf(reach1, fabsf(sampleW1[s]));
+        reach2 = fmaxf(reach2, fabsf(sampleW0[s] + sampleW1[s]));
+    }
+
+    for (int y = ts.min_y; y <= ts.max_y; y++) {
+        for (int x = ts.min_x; x <= ts.max_x; x++) {
+            int pixelIndex = y * target->width + x;
+
+            // Barycentric coordinates at the pixel centre, as in DrawTriangle
+            float px = (float)x + 0.5f;
+            float py = (float)y + 0.5f;
+            float centreW0 = ((s1.x - px)*(s2.y - py) - (s1.y - py)*(s2.x - px)) / area;
+            float centreW1 = ((s2.x - px)*(s0.y - py) - (s2.y - py)*(s0.x - px)) / area;
+            float centreW2 = 1.0f - centreW0 - centreW1;
+
+            // No sample can be inside when the centre is this far outside an edge
+            if (centreW0 < -reach0 || centreW1 < -reach1 || centreW2 < -reach2) continue;
+
+            // Coverage and depth at each sample
+            uint32_t mask = 0;
+            float sampleDepth[MSAA_SAMPLES];
+            for (int s = 0; s < MSAA_SAMPLES; s++) {
+                float w0 = centreW0 + sampleW0[s];
+                float w1 = centreW1 + sampleW1[s];
+                float w2 = 1.0f - w0 - w1;
+
+                if (w0 >= 0.0f && w1 >= 0.0f && w2 >= 0.0f) {
+                    mask |= 1u << s;
+                    sampleDepth[s] = w0 * ts.depth0 + w1 * ts.depth1 + w2 * ts.depth2;
+                }
+            }
+            if (!mask) continue;
+
+            // Centroid sampling: on partly covered pixels the centre may lie outside the
+            // triangle, where the light space position is extrapolated and the shadow
+            // lookup lands on other geometry. The mean of the covered samples is inside.
+            uint32_t pixelColour = packed;
+            if (ss.active) {
+                float shadeW0 = centreW0, shadeW1 = centreW1, shadeW2 = centreW2;
+                if (mask != MSAA_FULL_MASK) {
+                    float sum0 = 0.0f, sum1 = 0.0f;
+                    int covered = 0;
+                    for (int s = 0; s < MSAA_SAMPLES; s++) {
+                        if (!(mask & (1u << s))) continue;
+                        sum0 += sampleW0[s];
+                        sum1 += sampleW1[s];
+                        covered++;
+                    }
+                    shadeW0 = centreW0 + sum0 / (float)covered;
+                    shadeW1 = centreW1 + sum1 / (float)covered;
+                    shadeW2 = 1.0f - shadeW0 - shadeW1;
+                }
+                pixelColour = ShadePixel(&ss, &ts, shadow, shadeW0, shadeW1, shadeW2);
+            }
+
+            uint32_t meta = target->meta[pixelIndex];
+            if (meta & MSAA_EXPANDED) {
+                MsaaSampleBlock *block = &target->blocks[meta & ~MSAA_EXPANDED];
+                for (int s = 0; s < MSAA_SAMPLES; s++) {
+                    if ((mask & (1u << s)) && sampleDepth[s] > block->depth[s]) {
+                        block->depth[s] = sampleDepth[s];
+                        block->colour[s] = pixelColour;
+                    }
+                }
+                continue;
+            }
+
+            // Depth test against the samples of the compressed pixel's triangle
+            Vec2 slope = target->slopes[meta];
+            float centre = target->depth[pixelIndex];
+            uint32_t passed = 0;
+            for (int s = 0; s < MSAA_SAMPLES; s++) {
+                float stored = centre + slope.x * MSAA_SAMPLE_OFFSETS[s].x + slope.y * MSAA_SAMPLE_OFFSETS[s].y;
+                if ((mask & (1u << s)) && sampleDepth[s] > stored) passed |= 1u << s;
+            }
+            if (!passed) continue;
+
+            // Every sample now belongs to this triangle, so the pixel stays compressed.
+            // The sample offsets cancel out, so their mean is the centre depth.
+            if (passed == MSAA_FULL_MASK) {
+                if (slopeIndex == UINT32_MAX) slopeIndex = MsaaAddSlopes(target, dzdx, dzdy);
+                target->depth[pixelIndex] = (sampleDepth[0] + sampleDepth[1] + sampleDepth[2] + sampleDepth[3]) * 0.25f;
+                target->colour[pixelIndex] = pixelColour;
+                target->meta[pixelIndex] = slopeIndex;
+                continue;
+            }
+
+            // Edge pixel: split into per-sample storage
+            MsaaSampleBlock *block = MsaaExpandPixel(target, pixelIndex);
+            for (int s = 0; s < MSAA_SAMPLES; s++) {
+                if (passed & (1u << s)) {
+                    block->depth[s] = sampleDepth[s];
+                    block->colour[s] = pixelColour;
+                }
+            }
+        }
+    }
+}
+
+// Edge function from -> to, relative to from so large texel coordinates don't
+// cost precision. Positive on the inside of a positive area triangle.
+typedef struct {
+    float a, b;
+    Vec2 origin;
+} DepthEdge;
+
+static inline DepthEdge MakeDepthEdge(Vec3 from, Vec3 to) {
+    return (DepthEdge){ from.y - to.y, to.x - from.x, { from.x, from.y } };
+}
+
+static inline float EvalDepthEdge(const DepthEdge *e, float x, float y) {
+    return e->a * (x - e->origin.x) + e->b * (y - e->origin.y);
+}
+
+// Depth-only rasterizer for the shadow map. The light projection is
+// orthographic, so there is no perspective divide and depth is a plane over
+// the map. Works an 8x8 tile at a time: tiles wholly outside an edge or
+// behind everything already in them are skipped, and tiles wholly inside the
+// triangle skip the edge tests. tileMax is kept as an upper bound, lowered
+// only by fully covered tiles, so it never has to be rescanned.
+void DrawTriangleDepth(Triangle tri, ShadowMap *map) {
+    Vec3 t0 = LightTexel(map, tri.v0.pos);
+    Vec3 t1 = LightTexel(map, tri.v1.pos);
+    Vec3 t2 = LightTexel(map, tri.v2.pos);
+
+    // Texel y points down, so faces turned towards the light have positive area.
+    // The rest are shaded as unlit anyway and hidden behind the lit side.
+    float area = (t1.x - t0.x) * (t2.y - t0.y) - (t1.y - t0.y) * (t2.x - t0.x);
+    if (area <= 0.0f) return;
+
+    int size = map->size;
+    int min_x = (int)fmaxf(0.0f, floorf(fminf(fminf(t0.x, t1.x), t2.x)));
+    int max_x = (int)fminf(size - 1, ceilf(fmaxf(fmaxf(t0.x, t1.x), t2.x)));
+    int min_y = (int)fmaxf(0.0f, floorf(fminf(fminf(t0.y, t1.y), t2.y)));
+    int max_y = (int)fminf(size - 1, ceilf(fmaxf(fmaxf(t0.y, t1.y), t2.y)));
+    if (min_x > max_x || min_y > max_y) return;
+
+    // Edge i is opposite vertex i, so edge i / area is that vertex's barycentric weight
+    DepthEdge edges[3] = { MakeDepthEdge(t1, t2), MakeDepthEdge(t2, t0), MakeDepthEdge(t0, t1) };
+    float dzdx = (t0.z * edges[0].a + t1.z * edges[1].a + t2.z * edges[2].a) / area;
+    float dzdy = (t0.z * edges[0].b + t1.z * edges[1].b + t2.z * edges[2].b) / area;
+    float triMinZ = fminf(fminf(t0.z, t1.z), t2.z);
+
+    // How far each edge and the depth plane can move from a tile's first texel
+    // centre across the rest of the tile, constant for the whole triangle
+    const float span = (float)(SHADOW_TILE - 1);
+    float edgeUp[3], edgeDown[3];
+    for (int i = 0; i < 3; i++) {
+        edgeUp[i] = (fmaxf(edges[i].a, 0.0f) + fmaxf(edges[i].b, 0.0f)) * span;
+        edgeDown[i] = (fminf(edges[i].a, 0.0f) + fminf(edges[i].b, 0.0f)) * span;
+    }
+
+    // Texel offsets of the nearest and farthest corners of any tile, evaluated
+    // with the same arithmetic as the texel loops so the bounds round the same way
+    float nearX = dzdx < 0.0f ? span : 0.0f, nearY = dzdy < 0.0f ? span : 0.0f;
+    float farX = span - nearX, farY = span - nearY;
+
+    for (int ty = min_y / SHADOW_TILE; ty <= max_y / SHADOW_TILE; ty++) {
+        for (int tx = min_x / SHADOW_TILE; tx <= max_x / SHADOW_TILE; tx++) {
+            int x0 = tx * SHADOW_TILE, y0 = ty * SHADOW_TILE;
+            float px = (float)x0 + 0.5f, py = (float)y0 + 0.5f;
+
+            // Edge values at the tile's first texel, and their extremes over the tile
+            float e[3];
+            bool outside = false, inside = true;
+            for (int i = 0; i < 3; i++) {
+                e[i] = EvalDepthEdge(&edges[i], px, py);
+                outside |= e[i] + edgeUp[i] < 0.0f;
+                inside &= e[i] + edgeDown[i] >= 0.0f;
+            }
+            if (outside) continue;
+
+            // The plane can dip below the triangle outside it, the nearest vertex can't
+            float z = t0.z + dzdx * (px - t0.x) + dzdy * (py - t0.y);
+            float nearest = (z + dzdy * nearY) + dzdx * nearX;
+            if (nearest < triMinZ) nearest = triMinZ;
+            float *tileMax = &map->tileMax[ty * map->tilesPerSide + tx];
+            if (nearest >= *tileMax) continue;
+
+            // Fully covered: a plain depth min, after which nothing in the tile is
+            // farther than the plane's far corner
+            if (inside) {
+                for (int y = 0; y < SHADOW_TILE; y++) {
+                    float *row = map->depth + (y0 + y) * size + x0;
+                    float rowZ = z + dzdy * (float)y;
+                    for (int x = 0; x < SHADOW_TILE; x++) {
+                        float depth = rowZ + dzdx * (float)x;
+                        row[x] = depth < row[x] ? depth : row[x];
+                    }
+                }
+                float farthest = (z + dzdy * farY) + dzdx * farX;
+                if (farthest < *tileMax) *tileMax = farthest;
+                continue;
+            }
+
+            // Partly covered: only the texels inside the bounding box. Selects rather
+            // than branches, edge texels would mispredict constantly. The tile's
+            // farthest depth is left as is, writes only make it a looser bound.
+            int startX = min_x > x0 ? min_x - x0 : 0;
+            int endX = max_x < x0 + SHADOW_TILE - 1 ? max_x - x0 : SHADOW_TILE - 1;
+            int startY = min_y > y0 ? min_y - y0 : 0;
+            int endY = max_y < y0 + SHADOW_TILE - 1 ? max_y - y0 : SHADOW_TILE - 1;
+            for (int y = startY; y <= endY; y++) {
+                float *row = map->depth + (y0 + y) * size + x0;
+                float rowZ = z + dzdy * (float)y;
+                float e0 = e[0] + edges[0].b * (float)y;
+                float e1 = e[1] + edges[1].b * (float)y;
+                float e2 = e[2] + edges[2].b * (float)y;
+                for (int x = startX; x <= endX; x++) {
+                    float depth = rowZ + dzdx * (float)x;
+                    bool pass = (e0 + edges[0].a * (float)x >= 0.0f) & (e1 + edges[1].a * (float)x >= 0.0f) &
+                                (e2 + edges[2].a * (float)x >= 0.0f) & (depth < row[x]);
+                    row[x] = pass ? depth : row[x];
+                }
+            }
+        }
+    }
+}
+
+void ClearFrameBuffers(int window_height, int window_width, float *zbuffer, uint32_t *pixelBuffer, int pixelPitch) {
+    // Clear pixel buffer to 0 (black), row by row since rows may be padded
+    if (pixelPitch == window_width) {
+        memset(pixelBuffer, 0, sizeof(uint32_t) * window_width * window_height);
+    } else {
+        for (int y = 0; y < window_height; y++) {
+            memset(pixelBuffer + y * pixelPitch, 0, sizeof(uint32_t) * window_width);
+        }
+    }
+
+    // Initialize zbuffer with infinity
+    int totalPixels = window_width * window_height;
+    for (int i = 0; i < totalPixels; i++) {
+        zbuffer[i] = -INFINITY;
+    }
+}
+
+// Clears the buffers and rasterizes every visible triangle into them
+void RasterizeScene(int window_height, int window_width, float *zbuffer, Mat4 model, Triangle *tris,
+        Vec3 camPos, Mat4 mvp, Vec4 *triangleColours, const MeshCullData *cull, uint32_t *pixelBuffer,
+        int pixelPitch, MsaaBuffer *msaa, const ShadowMap *shadow) {
+    if (msaa) {
+        MsaaClear(msaa);
+    } else {
+        ClearFrameBuffers(window_height, window_width, zbuffer, pixelBuffer, pixelPitch);
+    }
+
+    // Camera position in model space, where all precomputed cull data lives
+    Vec3 camModel = mat4_mul_vec3(mat4_inverse(model), camPos);
+
+    Vec4 frustumPlanes[FRUSTUM_PLANE_COUNT];
+    ExtractFrustumPlanes(mvp, frustumPlanes);
+
+    // Reject whole meshlets first, then back-facing triangles of the survivors
+    for (int m = 0; m < cull->meshletCount; m++) {
+        const Meshlet *meshlet = &cull->meshlets[m];
+        if (!MeshletVisible(meshlet, frustumPlanes, camModel)) continue;
+
+        for (int j = meshlet->firstTri; j < meshlet->firstTri + meshlet->triCount; j++) {
+            int i = cull->meshletTris[j];
+
+            // Backface culling: skip triangle if normal points away from camera
+            if (!TriangleFrontFacing(cull->facePlanes[i], camModel)) continue;
+
+            // Draw the triangle using the model-view-projection matrix
+            if (msaa) {
+                DrawTriangleMsaa(tris[i], mvp, triangleColours[i], msaa, shadow);
+            } else {
+                DrawTriangle(tris[i], mvp, window_width, window_height, triangleColours[i], zbuffer,
+                        pixelBuffer, pixelPitch, shadow);
+            }
+        }
+    }
+
+    if (msaa) MsaaResolve(msaa, pixelBuffer, pixelPitch, zbuffer);
+}
+
+Vec4 TriangleIdColour(uint64_t id) {
+    uint64_t h = (id + 1) * 0x9E3779B97F4A7C15ull;
+    h ^= h >> 29;
+    return (Vec4){
+        (float)((h >> 0) & 0xFF) / 255.0f,
+        (float)((h >> 8) & 0xFF) / 255.0f,
+        (float)((h >> 16) & 0xFF) / 255.0f,
+        1.0f
+    };
+}
+
+// Draws a raw triangle soup in world space, culling back faces on the fly
+void RasterizeTriangles(const Triangle *tris, int count, uint64_t firstId, Vec3 camPos, Mat4 mvp,
+        int window_height, int window_width, float *zbuffer, uint32_t *pixelBuffer, int pixelPitch,
+        MsaaBuffer *msaa, const ShadowMap *shadow) {
+    for (int i = 0; i < count; i++) {
+        const Triangle *tri = &tris[i];
+
+        // Unnormalized normal is enough for the sign test
+        Vec3 normal = vec3_cross(vec3_sub(tri->v1.pos, tri->v0.pos), vec3_sub(tri->v2.pos, tri->v0.pos));
+        if (vec3_dot(normal, vec3_sub(camPos, tri->v0.pos)) < 0.0f) continue;
+
+        if (msaa) {
+            DrawTriangleMsaa(*tri, mvp, TriangleIdColour(firstId + i), msaa, shadow);
+        } else {
+            DrawTriangle(*tri, mvp, window_width, window_height, TriangleIdColour(firstId + i), zbuffer,
+                    pixelBuffer, pixelPitch, shadow);
+        }
+    }
+}
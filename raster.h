@@ -0,0 +1,49 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stdint.h>
+#include "calcs.h"
+#include "meshlet.h"
+#include "msaa.h"
+#include "shadow.h"
+
+// ==== Rasterizer core ====
+// Pure CPU rendering into caller-owned buffers, no SDL dependency, so the
+// same code runs in the window, headless tests and batch tools.
+//
+// pixelPitch is the row stride of pixelBuffer in pixels, which lets the
+// window draw straight into a locked texture. pixelBuffer is only ever
+// written, never read back. The zbuffer is always tightly packed.
+//
+// shadow lights the scene with a rendered shadow map (see shadow.h); pass
+// NULL for plain flat colours. The map must be in the triangles' space.
+
+void DrawTriangle(Triangle tri, Mat4 mvp, int screen_width, int screen_height, Vec4 colour,
+        float *zbuffer, uint32_t *pixelBuffer, int pixelPitch, const ShadowMap *shadow);
+
+// Multi-sampled DrawTriangle, writes into the MSAA buffer instead
+void DrawTriangleMsaa(Triangle tri, Mat4 mvp, Vec4 colour, MsaaBuffer *target, const ShadowMap *shadow);
+
+// Depth-only DrawTriangle into a shadow map through its light matrix. Only
+// faces turned towards the light are drawn, nearest wins.
+void DrawTriangleDepth(Triangle tri, ShadowMap *map);
+
+// Clears colour to black and depth to -infinity
+void ClearFrameBuffers(int window_height, int window_width, float *zbuffer, uint32_t *pixelBuffer, int pixelPitch);
+
+// With msaa set the scene is drawn multi-sampled and resolved into pixelBuffer
+// and zbuffer at the end; pass NULL for one sample per pixel.
+void RasterizeScene(int window_height, int window_width, float *zbuffer, Mat4 model, Triangle *tris,
+        Vec3 camPos, Mat4 mvp, Vec4 *triangleColours, const MeshCullData *cull, uint32_t *pixelBuffer,
+        int pixelPitch, MsaaBuffer *msaa, const ShadowMap *shadow);
+
+// Stable colour for a triangle identified only by its global index
+Vec4 TriangleIdColour(uint64_t id);
+
+// Draws world-space triangles without precomputed cull data (streamed pages).
+// Buffers are not cleared, and an msaa buffer is not resolved.
+void RasterizeTriangles(const Triangle *tris, int count, uint64_t firstId, Vec3 camPos, Mat4 mvp,
+        int window_height, int window_width, float *zbuffer, uint32_t *pixelBuffer, int pixelPitch,
+        MsaaBuffer *msaa, const ShadowMap *shadow);
+
+#endif
@@ -1,11 +1,80 @@
 #include "renderer.h"
+#include "raster.h"
 #include <SDL3/SDL.h>
 #include <SDL3_ttf/SDL_ttf.h>
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifdef CRASTER_DEBUG_ALLOCS
+// Frames rendered before the no-allocation assertion kicks in (driver/pool warm-up)
+#define DEBUG_ALLOC_WARMUP_FRAMES 60
+
+static SDL_AtomicInt allocCount;
+static SDL_malloc_func realMalloc;
+static SDL_calloc_func realCalloc;
+static SDL_realloc_func realRealloc;
+static SDL_free_func realFree;
+
+static void* SDLCALL CountingMalloc(size_t size) {
+    SDL_AddAtomicInt(&allocCount, 1);
+    return realMalloc(size);
+}
+
+static void* SDLCALL CountingCalloc(size_t nmemb, size_t size) {
+    SDL_AddAtomicInt(&allocCount, 1);
+    return realCalloc(nmemb, size);
+}
+
+static void* SDLCALL CountingRealloc(void *mem, size_t size) {
+    SDL_AddAtomicInt(&allocCount, 1);
+    return realRealloc(mem, size);
+}
+
+static void SDLCALL CountingFree(void *mem) {
+    realFree(mem);
+}
+
+// Every malloc, calloc and realloc linked into the executable (rasterizer,
+// loader, libc users) lands here through the linker's --wrap option
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *mem, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    SDL_AddAtomicInt(&allocCount, 1);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size) {
+    SDL_AddAtomicInt(&allocCount, 1);
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *mem, size_t size) {
+    SDL_AddAtomicInt(&allocCount, 1);
+    return __real_realloc(mem, size);
+}
+
+// Also routes SDL's (and SDL_ttf's) own heap allocations through the counter,
+// since a shared SDL calls malloc from outside the wrapped executable.
+// Must run before any other SDL call.
+void AllocCounterInstall(void) {
+    SDL_GetOriginalMemoryFunctions(&realMalloc, &realCalloc, &realRealloc, &realFree);
+    SDL_SetMemoryFunctions(CountingMalloc, CountingCalloc, CountingRealloc, CountingFree);
+}
+
+int AllocCounterGet(void) {
+    return SDL_GetAtomicInt(&allocCount);
+}
+#endif
 
 int WindowInit(SDL_Window **window, SDL_Renderer **rend, int width, int height) {
+#ifdef CRASTER_DEBUG_ALLOCS
+    AllocCounterInstall();
+#endif
+
     // Initialize SDL subsystem
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         printf("SDL_Init Error: %s\n", SDL_GetError());
@@ -34,242 +103,188 @@ int WindowInit(SDL_Window **window, SDL_Renderer **rend, int width, int height)
     return 0;
 }
 
-// Rasterizes a triangle on screen with depth buffering and colour
-void DrawTriangle(SDL_Renderer *ren, Triangle tri, 
-        Mat4 mvp, int screen_width, int screen_height, Vec4 colour, float *zbuffer, uint32_t *pixelBuffer) {
-    // Transform vertices to clip space
-    Vec4 p0 = mat4_mul_vec4(mvp, vec4_from_vec3(tri.v0.pos, 1.0f));
-    Vec4 p1 = mat4_mul_vec4(mvp, vec4_from_vec3(tri.v1.pos, 1.0f));
-    Vec4 p2 = mat4_mul_vec4(mvp, vec4_from_vec3(tri.v2.pos, 1.0f));
-
-    // Perform backface culling: skip any triangle if the vertex is behind the camera
-    if (p0.w >= 0.0f || p1.w >= 0.0f || p2.w >= 0.0f) return;
-
-    // Perspective divide to get normalized device coordinates
-    p0 = vec4_scale(p0, 1.0f / p0.w);
-    p1 = vec4_scale(p1, 1.0f / p1.w);
-    p2 = vec4_scale(p2, 1.0f / p2.w);
-
-    // Convert normalized device coords to screen space
-    Vec2 s0 = { (p0.x + 1.0f) * 0.5f * screen_width, (1.0f - p0.y) * 0.5f * screen_height };
-    Vec2 s1 = { (p1.x + 1.0f) * 0.5f * screen_width, (1.0f - p1.y) * 0.5f * screen_height };
-    Vec2 s2 = { (p2.x + 1.0f) * 0.5f * screen_width, (1.0f - p2.y) * 0.5f * screen_height };
-
-    // Compute bounding box for triangle in screen space
-    int min_x = (int)fmaxf(0.0f, floorf(fminf(fminf(s0.x, s1.x), s2.x)));
-    int max_x = (int)fminf(screen_width - 1, ceilf(fmaxf(fmaxf(s0.x, s1.x), s2.x)));
-    int min_y = (int)fmaxf(0.0f, floorf(fminf(fminf(s0.y, s1.y), s2.y)));
-    int max_y = (int)fminf(screen_height - 1, ceilf(fmaxf(fmaxf(s0.y, s1.y), s2.y)));
-    
-    // Calculate twice the area of the triangle for barycentric coords calculation
-    float area = (s1.x - s0.x) * (s2.y - s0.y) - (s1.y - s0.y) * (s2.x - s0.x);
-    if (area == 0.0f) return;
-
-    // Precompute depth values (in [0, 1])
-    float depth0 = (p0.z + 1.0f) * 0.5f;
-    float depth1 = (p1.z + 1.0f) * 0.5f;
-    float depth2 = (p2.z + 1.0f) * 0.5f;
-    
-    // Loop over each pixel in the bounding box to rasterize the triangle
-    for (int y = min_y; y <= max_y; y++) {
-        float *zrow = zbuffer + y * screen_width; // Row pointer for zbuffer optimization
-        for (int x = min_x; x <= max_x; x++) {
-            int pixelIndex = y * screen_width + x;
-
-            // Pixel center coordinates for barycentric calculation
-            float px = (float)x + 0.5f;
-            float py = (float)y + 0.5f;
-
-            // Compute barycentric coordinates for the pixel relative to the triangle
-            float w0 = ((s1.x - px)*(s2.y - py) - (s1.y - py)*(s2.x - px)) / area;
-            float w1 = ((s2.x - px)*(s0.y - py) - (s2.y - py)*(s0.x - px)) / area;
-            float w2 = 1.0f - w0 - w1;
-
-            // If the pixel lies inside the triangle
-            if (w0 >= 0.0f && w1 >= 0.0f && w2 >= 0.0f) {
-                // Interpolate depth at pixel using barycentric weights
-                float depth = w0 * depth0 + w1 * depth1 + w2 * depth2;
-
-                // Depth test update only if closer than current z value
-                if (depth > zrow[x]) {
-                    zrow[x] = depth; // Update our zbuffer with our depth
-
-                    // Pack ARGB colour into 32 bit integer and pixel update buffer
-                    pixelBuffer[pixelIndex] =
-                        ((Uint8)(colour.w * 255.0f) << 24) | // Alpha
-                        ((Uint8)(colour.x * 255.0f) << 16) | // Red
-                        ((Uint8)(colour.y * 255.0f) << 8)  | // Green
-                        ((Uint8)(colour.z * 255.0f) << 0);   // Blue
-
-                } 
-            }
+// Renders every printable glyph once and packs them into one texture
+bool GlyphAtlasInit(GlyphAtlas *atlas, SDL_Renderer *ren, TTF_Font *font) {
+    memset(atlas, 0, sizeof(GlyphAtlas));
+    if (!font || !ren) return false;
+
+    // Glyphs that fail to render are left blank but still advance the pen
+    SDL_Surface *glyphs[GLYPH_COUNT];
+    int cellW = 1, cellH = 1;
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        char glyph[2] = { (char)(GLYPH_FIRST + i), '\0' };
+        glyphs[i] = TTF_RenderText_Blended(font, glyph, 1, (SDL_Color){255, 255, 255, 255});
+
+        int advance = 0;
+        if (!TTF_GetGlyphMetrics(font, (Uint32)glyph[0], NULL, NULL, NULL, NULL, &advance) && glyphs[i]) {
+            advance = glyphs[i]->w;
         }
-    }
-}
-
-// Create an SDL_Texture containing rendered multiline text
-SDL_Texture* DrawText(char *message, SDL_Color txtColour, SDL_Renderer *ren, TTF_Font *font) {
-    if (!message || !font || !ren) return NULL;
+        atlas->advance[i] = (float)advance;
 
-    // Duplicate message for tokenizing without modifying original
-    char *msgCopy = strdup(message);
-    if (!msgCopy) {
-        fprintf(stderr, "Failed to allocate memory for message copy\n");
-        return NULL;
+        if (glyphs[i]) {
+            if (glyphs[i]->w > cellW) cellW = glyphs[i]->w;
+            if (glyphs[i]->h > cellH) cellH = glyphs[i]->h;
+        }
     }
 
-    // Count lines by counting \n
-    int linesCount = 1;
-    for (const char *p = message; *p; p++) {
-        if (*p == '\n') linesCount++;
+    int rows = (GLYPH_COUNT + GLYPH_ATLAS_COLUMNS - 1) / GLYPH_ATLAS_COLUMNS;
+    SDL_Surface *sheet = SDL_CreateSurface(cellW * GLYPH_ATLAS_COLUMNS, cellH * rows, SDL_PIXELFORMAT_RGBA32);
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        if (sheet && glyphs[i]) {
+            SDL_Rect dstRect = {(i % GLYPH_ATLAS_COLUMNS) * cellW, (i / GLYPH_ATLAS_COLUMNS) * cellH,
+                glyphs[i]->w, glyphs[i]->h};
+            // Copy coverage as is rather than blending it onto the empty sheet
+            SDL_SetSurfaceBlendMode(glyphs[i], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(glyphs[i], NULL, sheet, &dstRect);
+            atlas->glyphs[i] = (SDL_FRect){(float)dstRect.x, (float)dstRect.y, (float)dstRect.w, (float)dstRect.h};
+        }
+        SDL_DestroySurface(glyphs[i]);
     }
-
-    // Allocate array to store pointers to each line string
-    char **lines = (char **)malloc(linesCount * sizeof(char *));
-    if (!lines) {
-        free(lines);
-        free(msgCopy);
-        fprintf(stderr, "Failed to allocate memory for lines array\n");
-        return NULL;
+    if (!sheet) {
+        fprintf(stderr, "Failed to create glyph atlas surface: %s\n", SDL_GetError());
+        return false;
     }
 
-    // Tokenize message copy into individual lines separated by newline
-    int idx = 0;
-    char *line = strtok(msgCopy, "\n");
-    while (line && idx < linesCount) {
-        lines[idx++] = line;
-        line = strtok(NULL, "\n");
-    }
+    atlas->texture = SDL_CreateTextureFromSurface(ren, sheet);
+    atlas->width = (float)sheet->w;
+    atlas->height = (float)sheet->h;
+    atlas->lineHeight = (float)TTF_GetFontHeight(font);
+    SDL_DestroySurface(sheet);
 
-    // Allocate array for SDL_Surface pointers, one for each line
-    SDL_Surface **surfaces = (SDL_Surface **)malloc(linesCount * sizeof(SDL_Surface *));
-    if (!surfaces) {
-        free(lines);
-        free(msgCopy);
-        fprintf(stderr, "Failed to allocate memory for surfaces\n");
-        return NULL;
+    if (!atlas->texture) {
+        fprintf(stderr, "Failed to create glyph atlas texture: %s\n", SDL_GetError());
+        return false;
     }
+    return true;
+}
 
-    // Render each line into a surface and compute total size needed
-    int totalHeight = 0;
-    int maxWidth = 0;
-    for (int i = 0; i < linesCount; i++) {
-        surfaces[i] = TTF_RenderText_Blended(font, lines[i], 0, txtColour);
-        if (!surfaces[i]) {
-            fprintf(stderr, "Failed to render line %d: %s\n", i, SDL_GetError());
-            // Cleanup on failure
-            for (int j = 0; j < i; j++) SDL_DestroySurface(surfaces[j]);
-            free(surfaces);
-            free(lines);
-            free(msgCopy);
-            return NULL;
-        }
-        if (surfaces[i]->w > maxWidth) maxWidth = surfaces[i]->w; // Track max width
-        totalHeight += surfaces[i]->h; // Sum heights
-    }
+void GlyphAtlasDestroy(GlyphAtlas *atlas) {
+    if (atlas->texture) SDL_DestroyTexture(atlas->texture);
+    memset(atlas, 0, sizeof(GlyphAtlas));
+}
 
-    // Create a combined surface large enough to hold all lines vertically stacked
-    SDL_Surface *combined = SDL_CreateSurface(maxWidth, totalHeight, SDL_PIXELFORMAT_RGBA32);
-    if (!combined) {
-        fprintf(stderr, "Failed to create combined surface: %s\n", SDL_GetError());
-        for (int i = 0; i < linesCount; i++) SDL_DestroySurface(surfaces[i]);
-        free(surfaces);
-        free(lines);
-        free(msgCopy);
-        return NULL;
-    }
+// Draws multiline text with its top left corner at (x, y) as one batch of
+// textured quads. The quads are built in the frame arena so no heap calls are made here.
+void DrawText(const GlyphAtlas *atlas, SDL_Renderer *ren, const char *message, float x, float y,
+        SDL_Color txtColour, Arena *arena) {
+    if (!atlas->texture || !message || !ren || !arena) return;
 
-    // Copy (blit) each line surface onto the combined surface one below the other
-    int yOffset = 0;
-    for (int i = 0; i < linesCount; i++) {
-        SDL_Rect dstRect = {0, yOffset, surfaces[i]->w, surfaces[i]->h};
-        SDL_BlitSurface(surfaces[i], NULL, combined, &dstRect);
-        yOffset += surfaces[i]->h; // Increment vertical offset
-        SDL_DestroySurface(surfaces[i]); // Free individual line surface after blit
-    }
+    size_t length = strlen(message);
+    if (length == 0) return;
 
-    // Cleanup: free individual surfaces and lines array
-    free(surfaces);
-    free(lines);
-    free(msgCopy);
+    SDL_Vertex *vertices = arena_alloc(arena, length * 4 * sizeof(SDL_Vertex));
+    int *indices = arena_alloc(arena, length * 6 * sizeof(int));
+    if (!vertices || !indices) {
+        fprintf(stderr, "Failed to allocate memory for text quads\n");
+        return;
+    }
 
-    // Create texture from combined surface
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(ren, combined);
-    SDL_DestroySurface(combined);
+    SDL_FColor colour = {txtColour.r / 255.0f, txtColour.g / 255.0f, txtColour.b / 255.0f, txtColour.a / 255.0f};
+    float penX = x;
+    float penY = y;
+    int quads = 0;
+    for (const char *p = message; *p; p++) {
+        if (*p == '\n') {
+            penX = x;
+            penY += atlas->lineHeight;
+            continue;
+        }
 
-    if (!texture) {
-        fprintf(stderr, "Failed to create texture from combined surface: %s\n", SDL_GetError());
-        return NULL;
+        int g = (unsigned char)*p - GLYPH_FIRST;
+        if (g < 0 || g >= GLYPH_COUNT) continue;
+
+        const SDL_FRect *src = &atlas->glyphs[g];
+        if (src->w > 0.0f) {
+            float u0 = src->x / atlas->width;
+            float v0 = src->y / atlas->height;
+            float u1 = (src->x + src->w) / atlas->width;
+            float v1 = (src->y + src->h) / atlas->height;
+
+            SDL_Vertex *quad = vertices + quads * 4;
+            quad[0] = (SDL_Vertex){ {penX, penY}, colour, {u0, v0} };
+            quad[1] = (SDL_Vertex){ {penX + src->w, penY}, colour, {u1, v0} };
+            quad[2] = (SDL_Vertex){ {penX + src->w, penY + src->h}, colour, {u1, v1} };
+            quad[3] = (SDL_Vertex){ {penX, penY + src->h}, colour, {u0, v1} };
+
+            int base = quads * 4;
+            int *index = indices + quads * 6;
+            index[0] = base;
+            index[1] = base + 1;
+            index[2] = base + 2;
+            index[3] = base;
+            index[4] = base + 2;
+            index[5] = base + 3;
+            quads++;
+        }
+        penX += atlas->advance[g];
     }
 
-    return texture;
+    if (quads > 0) SDL_RenderGeometry(ren, atlas->texture, vertices, quads * 4, indices, quads * 6);
 }
 
-// Main rendering loop that handles drawing triangles and text
-void renderLoop(SDL_Renderer *ren, int window_height, int window_width, float *zbuffer, int triangleCount, 
-        Mat4 view, Mat4 model, Triangle *tris, Camera cam, Mat4 mvp, Vec4 *triangleColours, 
-        uint32_t *pixelBuffer, SDL_Texture *texture, TTF_Font *font, char *message) {
-    
-    // Clear pixel buffer to 0 (black)
-    memset(pixelBuffer, 0, sizeof(uint32_t) * window_width * window_height);
-
-    // Set renderer clear colour to black and clear the renderer
-    SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
-    SDL_RenderClear(ren);
-
-    // Initialize zbuffer with infinity
-    int totalPixels = window_width * window_height;
-    for (int i = 0; i < totalPixels; i++) {
-        zbuffer[i] = -INFINITY;
+// Rasterizes the scene into pixels (pixelPitch pixels per row), from the page
+// cache when streaming, multi-sampled and resolved when msaa is set. Streamed
+// pages are stored in world space, so model only applies to the loaded scene,
+// and they are never shadowed.
+static void RasterizeFrame(int window_height, int window_width, float *zbuffer, Mat4 model, Triangle *tris,
+        Camera cam, Mat4 mvp, Vec4 *triangleColours, const MeshCullData *cull, uint32_t *pixels, int pixelPitch,
+        PageStream *stream, MsaaBuffer *msaa, const ShadowMap *shadow) {
+    if (!stream) {
+        RasterizeScene(window_height, window_width, zbuffer, model, tris, cam.position, mvp,
+                triangleColours, cull, pixels, pixelPitch, msaa, shadow);
+        return;
     }
 
-    // Calculate model-view matrix (view * model)
-    Mat4 modelView = mat4_mul(view, model);
-
-    // Loop over all triangles to draw
-    for (int i = 0; i < triangleCount; i++) {
-        Triangle *tri = &tris[i];
-
-        // Transform triangle vertices to world space
-        Vec3 v0w = mat4_mul_vec3(model, tri->v0.pos);
-        Vec3 v1w = mat4_mul_vec3(model, tri->v1.pos);
-        Vec3 v2w = mat4_mul_vec3(model, tri->v2.pos);
-
-        // Calculate edges and face normal of the triangle
-        Vec3 edge1 = vec3_sub(v1w, v0w);
-        Vec3 edge2 = vec3_sub(v2w, v0w);
-        Vec3 normal = vec3_normalize(vec3_cross(edge1, edge2));
-
-        // Calculate centroid of the triangle for backface culling
-        Vec3 centroid = vec3_scale(vec3_add(vec3_add(v0w, v1w), v2w), 1.0f / 3.0f);
-
-        // Vector from triangle centroid to camera position
-        Vec3 toCamera = vec3_sub(cam.position, centroid);
-
-        // Backface culling: skip triangle if normal points away from camera
-        if (vec3_dot(normal, toCamera) < 0.0f) continue;
-
-        // Draw the triangle using the transformed vertices and model-view-projection matrix
-        DrawTriangle(ren, *tri, mvp, window_width, window_height, triangleColours[i], zbuffer, pixelBuffer);
+    if (msaa) {
+        MsaaClear(msaa);
+    } else {
+        ClearFrameBuffers(window_height, window_width, zbuffer, pixels, pixelPitch);
     }
+    PageStreamDraw(stream, mvp, cam.position, window_height, window_width, zbuffer, pixels, pixelPitch, msaa);
+    if (msaa) MsaaResolve(msaa, pixels, pixelPitch, zbuffer);
+}
 
-    // Update the texture with the pixel buffer
-    SDL_UpdateTexture(texture, NULL, pixelBuffer, window_width * sizeof(uint32_t));
+// Main rendering loop that handles drawing triangles and text
+void renderLoop(SDL_Renderer *ren, int window_height, int window_width, float *zbuffer,
+        Mat4 model, Triangle *tris, Camera cam, Mat4 mvp, Vec4 *triangleColours,
+        const MeshCullData *cull, uint32_t *pixelBuffer, SDL_Texture *texture, const char *message,
+        const GlyphAtlas *atlas, Arena *frameArena, PageStream *stream, MsaaBuffer *msaa,
+        const ShadowMap *shadow) {
+#ifdef CRASTER_DEBUG_ALLOCS
+    int allocsAtStart = AllocCounterGet();
+#endif
+
+    // No SDL_RenderClear: the scene texture covers the whole window every frame.
+    // Rasterize straight into the locked streaming texture, honouring its pitch,
+    // so there is no full-frame copy. Locked memory is write-only, which is all
+    // the rasterizer needs since depth lives in zbuffer.
+    void *lockedPixels = NULL;
+    int lockedPitch = 0;
+    if (SDL_LockTexture(texture, NULL, &lockedPixels, &lockedPitch)) {
+        RasterizeFrame(window_height, window_width, zbuffer, model, tris, cam, mvp, triangleColours, cull,
+                (uint32_t *)lockedPixels, lockedPitch / (int)sizeof(uint32_t), stream, msaa, shadow);
+        SDL_UnlockTexture(texture);
+    } else {
+        // Fall back to drawing in system memory and uploading
+        RasterizeFrame(window_height, window_width, zbuffer, model, tris, cam, mvp, triangleColours, cull,
+                pixelBuffer, window_width, stream, msaa, shadow);
+        SDL_UpdateTexture(texture, NULL, pixelBuffer, window_width * sizeof(uint32_t));
+    }
 
     // Render the updated texture to the renderer (fullscreen)
     SDL_RenderTexture(ren, texture, NULL, NULL);
 
-    // Render the message text as texture overlay
-    SDL_Texture *textTexture = DrawText(message, (SDL_Color){255, 255, 255, 255}, ren, font);
-    if (textTexture) {
-        float textW, textH;
-        SDL_GetTextureSize(textTexture, &textW, &textH);
-
-        SDL_FRect dstRect = {20, 20, (float)textW, (float)textH};
-        SDL_RenderTexture(ren, textTexture, NULL, &dstRect);
-        SDL_DestroyTexture(textTexture);
-    }
+    // Draw the message text over the frame from the prebuilt glyph atlas
+    DrawText(atlas, ren, message, 20.0f, 20.0f, (SDL_Color){255, 255, 255, 255}, frameArena);
 
     // Present the rendered frame to the window
     SDL_RenderPresent(ren);
+
+#ifdef CRASTER_DEBUG_ALLOCS
+    // Once warmed up, a frame must not touch the heap at all
+    static int debugFrameIndex = 0;
+    if (++debugFrameIndex > DEBUG_ALLOC_WARMUP_FRAMES) {
+        SDL_assert_always(AllocCounterGet() == allocsAtStart);
+    }
+#endif
 }
@@ -1,18 +1,45 @@
 #include <SDL3/SDL.h>
 #include <SDL3_ttf/SDL_ttf.h>
 #include "calcs.h"
+#include "arena.h"
+#include "meshlet.h"
+#include "pageStream.h"
+#include "msaa.h"
+#include "shadow.h"
 
 #ifndef FUNCTIONS_H_INCLUDED
 #define FUNCTIONS_H_INCLUDED
 
+// Printable ASCII, rendered once into a single atlas texture
+#define GLYPH_FIRST ' '
+#define GLYPH_COUNT ('~' - ' ' + 1)
+#define GLYPH_ATLAS_COLUMNS 16
+
+// Overlay font glyphs, so text is drawn each frame without creating surfaces or textures
+typedef struct {
+    SDL_Texture *texture;
+    float width, height;           // Atlas size in texels
+    SDL_FRect glyphs[GLYPH_COUNT]; // Where each glyph sits in the atlas
+    float advance[GLYPH_COUNT];    // Pen advance after each glyph
+    float lineHeight;
+} GlyphAtlas;
+
 int WindowInit(SDL_Window **window, SDL_Renderer **rend, int width, int height);
 
-void DrawTriangle(SDL_Renderer *ren, Triangle tri, 
-        Mat4 mvp, int screen_width, int screen_height, Vec4 colour, float *zbuffer, uint32_t *pixelBuffer);
+bool GlyphAtlasInit(GlyphAtlas *atlas, SDL_Renderer *ren, TTF_Font *font);
+void GlyphAtlasDestroy(GlyphAtlas *atlas);
 
-SDL_Texture* DrawText(char *message, SDL_Color txtColour, SDL_Renderer *ren, TTF_Font *font);
+void DrawText(const GlyphAtlas *atlas, SDL_Renderer *ren, const char *message, float x, float y,
+        SDL_Color txtColour, Arena *arena);
 
-void renderLoop(SDL_Renderer *ren, int window_height, int window_width, float *zbuffer, int triangleCount, 
-        Mat4 view, Mat4 model, Triangle *tris, Camera cam, Mat4 mvp, Vec4 *triangleColours, 
-        uint32_t *pixelBuffer, SDL_Texture *texture, TTF_Font *font, char *message);
+void renderLoop(SDL_Renderer *ren, int window_height, int window_width, float *zbuffer,
+        Mat4 model, Triangle *tris, Camera cam, Mat4 mvp, Vec4 *triangleColours,
+        const MeshCullData *cull, uint32_t *pixelBuffer, SDL_Texture *texture, const char *message,
+        const GlyphAtlas *atlas, Arena *frameArena, PageStream *stream, MsaaBuffer *msaa,
+        const ShadowMap *shadow);
+
+#ifdef CRASTER_DEBUG_ALLOCS
+void AllocCounterInstall(void);
+int AllocCounterGet(void);
+#endif
 #endif
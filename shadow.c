@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "shadow.h"
+#include "raster.h"
+
+bool ShadowMapInit(ShadowMap *map, int size, bool pcf) {
+    memset(map, 0, sizeof(ShadowMap));
+
+    // Round up to whole tiles so the tile loops never straddle the edge
+    size = (size + SHADOW_TILE - 1) / SHADOW_TILE * SHADOW_TILE;
+    map->size = size;
+    map->tilesPerSide = size / SHADOW_TILE;
+    map->pcf = pcf;
+    map->depth = malloc(sizeof(float) * size * size);
+    map->tileMax = malloc(sizeof(float) * map->tilesPerSide * map->tilesPerSide);
+    if (!map->depth || !map->tileMax) {
+        fprintf(stderr, "Failed to allocate %dx%d shadow map\n", size, size);
+        ShadowMapDestroy(map);
+        return false;
+    }
+
+    map->lightMatrix = mat4_identity();
+    map->lightDir = (Vec3){0, 1, 0};
+    return true;
+}
+
+void ShadowMapDestroy(ShadowMap *map) {
+    free(map->depth);
+    free(map->tileMax);
+    memset(map, 0, sizeof(ShadowMap));
+}
+
+void ShadowMapFitScene(ShadowMap *map, Vec3 lightDir, const Triangle *tris, int count) {
+    Vec3 boundsMin = { INFINITY, INFINITY, INFINITY };
+    Vec3 boundsMax = { -INFINITY, -INFINITY, -INFINITY };
+    for (int i = 0; i < count; i++) {
+        const Vec3 *corners[3] = { &tris[i].v0.pos, &tris[i].v1.pos, &tris[i].v2.pos };
+        for (int k = 0; k < 3; k++) {
+            boundsMin.x = fminf(boundsMin.x, corners[k]->x);
+            boundsMin.y = fminf(boundsMin.y, corners[k]->y);
+            boundsMin.z = fminf(boundsMin.z, corners[k]->z);
+            boundsMax.x = fmaxf(boundsMax.x, corners[k]->x);
+            boundsMax.y = fmaxf(boundsMax.y, corners[k]->y);
+            boundsMax.z = fmaxf(boundsMax.z, corners[k]->z);
+        }
+    }
+    if (count == 0) {
+        boundsMin = (Vec3){ -1, -1, -1 };
+        boundsMax = (Vec3){ 1, 1, 1 };
+    }
+
+    Vec3 center = vec3_scale(vec3_add(boundsMin, boundsMax), 0.5f);
+    float radius = fmaxf(0.5f * vec3_length(vec3_sub(boundsMax, boundsMin)), 1e-3f);
+
+    // Look at the scene from outside its bounding sphere; any up not parallel to the light works
+    map->lightDir = vec3_normalize(lightDir);
+    Vec3 up = fabsf(map->lightDir.y) > 0.99f ? (Vec3){0, 0, 1} : (Vec3){0, 1, 0};
+    Vec3 eye = vec3_sub(center, vec3_scale(map->lightDir, 2.0f * radius));
+    Mat4 view = mat4_look_at(eye, center, up);
+    Mat4 proj = mat4_orthographic(-radius, radius, -radius, radius, radius, 3.0f * radius);
+
+    map->lightMatrix = mat4_mul(proj, view);
+    map->texelWorld = 2.0f * radius / (float)map->size;
+    map->depthRange = 2.0f * radius;
+}
+
+void RenderShadowMap(ShadowMap *map, const Triangle *tris, int count) {
+    int texels = map->size * map->size;
+    for (int i = 0; i < texels; i++) {
+        map->depth[i] = INFINITY;
+    }
+    int tiles = map->tilesPerSide * map->tilesPerSide;
+    for (int i = 0; i < tiles; i++) {
+        map->tileMax[i] = INFINITY;
+    }
+
+    for (int i = 0; i < count; i++) {
+        DrawTriangleDepth(tris[i], map);
+    }
+}
+
+static inline bool TexelLit(const ShadowMap *map, int x, int y, float depth) {
+    if (x < 0 || y < 0 || x >= map->size || y >= map->size) return true;
+    return depth <= map->depth[y * map->size + x];
+}
+
+float ShadowMapLit(const ShadowMap *map, float u, float v, float depth) {
+    int x = (int)floorf(u);
+    int y = (int)floorf(v);
+    if (!map->pcf) return TexelLit(map, x, y, depth) ? 1.0f : 0.0f;
+
+    int lit = 0;
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            lit += TexelLit(map, x + dx, y + dy, depth);
+        }
+    }
+    return (float)lit / 9.0f;
+}
@@ -0,0 +1,42 @@
+#ifndef SHADOW_H
+#define SHADOW_H
+
+#include <stdbool.h>
+#include "calcs.h"
+
+// ==== Directional light shadow map ====
+// The scene is rendered depth-only from the light through an orthographic
+// projection, then the main pass compares each pixel's light-space depth
+// against the map. Everything is in the triangles' own (model) space.
+
+// Texels per side of a shadow map tile, the unit of the depth-only early-outs
+#define SHADOW_TILE 8
+
+typedef struct {
+    int size;           // Square map, texels per side (a multiple of SHADOW_TILE)
+    float *depth;       // Light-space depth in [0, 1], nearer is smaller
+    float *tileMax;     // Upper bound on the farthest depth in each tile, for hierarchical rejection
+    int tilesPerSide;
+
+    Mat4 lightMatrix;   // Model space to light clip space, w is always 1
+    Vec3 lightDir;      // Direction the light travels, normalized
+    float texelWorld;   // World size of one texel, for depth bias
+    float depthRange;   // World distance covered by depth 0..1
+    bool pcf;           // 3x3 percentage closer filtering instead of one tap
+} ShadowMap;
+
+bool ShadowMapInit(ShadowMap *map, int size, bool pcf);
+void ShadowMapDestroy(ShadowMap *map);
+
+// Points the light along lightDir and fits the orthographic volume around
+// the bounding sphere of the triangles
+void ShadowMapFitScene(ShadowMap *map, Vec3 lightDir, const Triangle *tris, int count);
+
+// Clears and renders every triangle facing the light into the map
+void RenderShadowMap(ShadowMap *map, const Triangle *tris, int count);
+
+// Fraction of the taps around texel position (u, v) that are lit at the given
+// light-space depth. Outside the map counts as lit.
+float ShadowMapLit(const ShadowMap *map, float u, float v, float depth);
+
+#endif
@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include <SDL3/SDL.h>
+
+#include "pageFile.h"
+#include "pageStream.h"
+#include "calcs.h"
+
+// Streams a synthetic page file whose index is larger than main.c's 4 MB
+// frame arena (12 bytes of per-update scratch per page), to check that scene
+// size is bounded only by the page index and not by per-frame scratch. A
+// second file points the pages nearest the camera past its end, more of them
+// than there are slots, to check that failed reads give their slots back.
+//
+// Usage: page_stream scratch_dir
+
+#define TEST_WIDTH  160
+#define TEST_HEIGHT 120
+// One triangle per page on a square grid: 640 * 640 pages, about 4.7 MB of scratch
+#define GRID_SIDE   640
+#define CELL_SIZE   0.1f
+#define GRID_DEPTH  -5.0f
+// Frames to wait for the loader before giving up
+#define MAX_FRAMES  2000
+// Pages within this distance of the view axis are unreadable in the broken file
+#define BROKEN_RADIUS 1.0f
+
+// Writes a page file with a GRID_SIDE x GRID_SIDE wall of small triangles
+// facing the camera, one triangle per page. With broken set, the pages near
+// the centre of the wall point past the end of the file.
+static bool WriteGridPageFile(const char *path, bool broken) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Failed to create %s\n", path);
+        return false;
+    }
+
+    uint32_t pageCount = GRID_SIDE * GRID_SIDE;
+    float half = GRID_SIDE * CELL_SIZE * 0.5f;
+    PageFileHeader header = {
+        .magic = PAGE_FILE_MAGIC,
+        .version = PAGE_FILE_VERSION,
+        .pageCount = pageCount,
+        .maxPageTris = PAGE_MAX_TRIS,
+        .triangleCount = pageCount,
+        .boundsMin = { -half, -half, GRID_DEPTH },
+        .boundsMax = { half, half, GRID_DEPTH },
+    };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    uint64_t dataStart = sizeof(PageFileHeader) + (uint64_t)sizeof(PageInfo) * pageCount;
+    uint64_t dataEnd = dataStart + (uint64_t)sizeof(Triangle) * pageCount;
+    for (uint32_t i = 0; ok && i < pageCount; i++) {
+        float x = -half + (float)(i % GRID_SIDE) * CELL_SIZE;
+        float y = -half + (float)(i / GRID_SIDE) * CELL_SIZE;
+        float cx = x + CELL_SIZE * 0.5f;
+        float cy = y + CELL_SIZE * 0.5f;
+        bool unreadable = broken && cx * cx + cy * cy < BROKEN_RADIUS * BROKEN_RADIUS;
+        PageInfo info = {
+            .boundsMin = { x, y, GRID_DEPTH },
+            .boundsMax = { x + CELL_SIZE, y + CELL_SIZE, GRID_DEPTH },
+            .dataOffset = unreadable ? dataEnd : dataStart + (uint64_t)sizeof(Triangle) * i,
+            .firstTriangle = i,
+            .triCount = 1,
+        };
+        ok = fwrite(&info, sizeof(info), 1, file) == 1;
+    }
+
+    // Wound to face the camera at the origin
+    for (uint32_t i = 0; ok && i < pageCount; i++) {
+        float x = -half + (float)(i % GRID_SIDE) * CELL_SIZE;
+        float y = -half + (float)(i / GRID_SIDE) * CELL_SIZE;
+        Triangle tri = {
+            { { x, y, GRID_DEPTH } },
+            { { x + CELL_SIZE, y, GRID_DEPTH } },
+            { { x, y + CELL_SIZE, GRID_DEPTH } },
+        };
+        ok = fwrite(&tri, sizeof(tri), 1, file) == 1;
+    }
+
+    if (fclose(file) != 0) ok = false;
+    if (!ok) fprintf(stderr, "Failed to write %s\n", path);
+    return ok;
+}
+
+// Streams the file until something is drawn, or MAX_FRAMES pass
+static bool StreamUntilDrawn(const char *path, const char *label) {
+    // Small budget, so the visible set is far larger than the resident one
+    PageStream *stream = OpenPageStream(path, 1024 * 1024);
+    if (!stream) return false;
+
+    float *zbuffer = malloc(sizeof(float) * TEST_WIDTH * TEST_HEIGHT);
+    uint32_t *pixels = malloc(sizeof(uint32_t) * TEST_WIDTH * TEST_HEIGHT);
+    if (!zbuffer || !pixels) {
+        fprintf(stderr, "Failed to allocate framebuffers\n");
+        ClosePageStream(stream);
+        free(zbuffer);
+        free(pixels);
+        return false;
+    }
+
+    // Same camera setup as main.c
+    Camera cam = { {0.0f, 0.0f, 0.0f}, 0.0f, 0.0f };
+    Mat4 proj = mat4_perspective(70.0f * (3.14159f / 180.0f), (float)TEST_WIDTH / TEST_HEIGHT, 0.1f, 100.0f);
+    Vec3 target = vec3_add(cam.position, get_camera_forward(cam));
+    Mat4 mvp = mat4_mul(proj, mat4_look_at(cam.position, target, (Vec3){0, 1, 0}));
+
+    // Keep updating until something has been loaded and drawn
+    PageStreamStats stats = {0};
+    int covered = 0;
+    for (int frame = 0; frame < MAX_FRAMES && covered == 0; frame++) {
+        PageStreamUpdate(stream, mvp, cam.position, (Vec3){0, 0, 0});
+
+        for (int i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++) {
+            zbuffer[i] = -INFINITY;
+            pixels[i] = 0;
+        }
+        PageStreamDraw(stream, mvp, cam.position, TEST_HEIGHT, TEST_WIDTH, zbuffer, pixels, TEST_WIDTH, NULL);
+        PageStreamGetStats(stream, &stats);
+
+        for (int i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++) {
+            if (pixels[i] != 0) covered++;
+        }
+        if (covered == 0) SDL_Delay(1);
+    }
+
+    bool pass = stats.visiblePages > 0 && stats.drawnPages > 0 && covered > 0;
+    printf("[page_stream %s] %s: %d pages, %d slots, %d visible, %d drawn, %d pixels covered\n",
+        label, pass ? "PASS" : "FAIL", stats.pageCount, stats.slotCount, stats.visiblePages,
+        stats.drawnPages, covered);
+
+    ClosePageStream(stream);
+    free(zbuffer);
+    free(pixels);
+    return pass;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s scratch_dir\n", argv[0]);
+        return 1;
+    }
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/page_stream_grid.pages", argv[1]);
+
+    bool pass = WriteGridPageFile(path, false) && StreamUntilDrawn(path, "large index");
+    pass = WriteGridPageFile(path, true) && StreamUntilDrawn(path, "failed reads") && pass;
+
+    remove(path);
+    return pass ? 0 : 1;
+}
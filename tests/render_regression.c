@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "raster.h"
+#include "calcs.h"
+#include "ImportObj.h"
+#include "meshlet.h"
+#include "imageIO.h"
+
+// Renders fixed camera poses of the bundled models headlessly and compares the
+// colour and depth buffers against golden images.
+//
+// Usage: render_regression [-t channel_tol] [-p max_bad_fraction] [-z depth_tol] [-u]
+//            models_dir golden_dir output_dir
+//   -u rewrites the golden images instead of comparing against them.
+
+#define TEST_WIDTH  160
+#define TEST_HEIGHT 120
+#define TEST_SHADOW_MAP_SIZE 512
+
+typedef struct {
+    const char *name;
+    const char *model;
+    Camera cam;
+    bool msaa;      // Render with 4x MSAA and resolve
+    bool shadows;   // Light with a PCF shadow map, same sun as main.c
+} RenderCase;
+
+static const RenderCase cases[] = {
+    { .name = "suzanne_front",    .model = "suzanne.obj",    .cam = { {0.0f, 0.0f, 3.0f},   0.0f,   0.0f  } },
+    { .name = "suzanne_side",     .model = "suzanne.obj",    .cam = { {2.2f, -0.8f, 2.2f},  0.785f, -0.25f } },
+    { .name = "scene_default",    .model = "scene.obj",      .cam = { {0.0f, 0.0f, 2.0f},   0.0f,   0.0f  } },
+    { .name = "scene_overview",   .model = "scene.obj",      .cam = { {16.0f, -12.0f, 20.0f}, 0.675f, -0.438f } },
+    { .name = "ico_sphere_front", .model = "ico_sphere.obj", .cam = { {0.0f, 0.0f, 3.0f},   0.0f,   0.0f  } },
+    { .name = "ico_sphere_close", .model = "ico_sphere.obj", .cam = { {0.9f, 0.6f, 1.4f},   0.57f,  0.3f  } },
+    { .name = "suzanne_side_msaa",  .model = "suzanne.obj",  .cam = { {2.2f, -0.8f, 2.2f},  0.785f, -0.25f },
+      .msaa = true },
+    { .name = "scene_overview_msaa", .model = "scene.obj",   .cam = { {16.0f, -12.0f, 20.0f}, 0.675f, -0.438f },
+      .msaa = true },
+    { .name = "scene_overview_shadow", .model = "scene.obj", .cam = { {16.0f, -12.0f, 20.0f}, 0.675f, -0.438f },
+      .shadows = true },
+    { .name = "scene_overview_msaa_shadow", .model = "scene.obj", .cam = { {16.0f, -12.0f, 20.0f}, 0.675f, -0.438f },
+      .msaa = true, .shadows = true },
+};
+
+typedef struct {
+    int channelTolerance;   // Max per-channel difference before a pixel counts as bad
+    double maxBadFraction;  // Fraction of bad pixels allowed (edge pixels may flip)
+    float depthTolerance;   // Max depth difference before a pixel counts as bad
+} Tolerance;
+
+// Deterministic stand-in for main.c's random colours
+static Vec4 TriangleColour(int index) {
+    return (Vec4){
+        (float)((index * 37 + 11) % 256) / 255.0f,
+        (float)((index * 91 + 53) % 256) / 255.0f,
+        (float)((index * 53 + 97) % 256) / 255.0f,
+        1.0f
+    };
+}
+
+// FNV-1a, printed so runs can be compared at a glance in the logs
+static uint64_t HashBytes(const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    uint64_t hash = 1469598103934665603ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static bool RenderCaseBuffers(const char *modelsDir, const RenderCase *rc, uint32_t *pixels, float *depth) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", modelsDir, rc->model);
+
+    int triangleCount = 0;
+    Triangle *tris = LoadObjTriangles(path, &triangleCount);
+    if (!tris || triangleCount == 0) {
+        fprintf(stderr, "[%s] failed to load %s\n", rc->name, path);
+        free(tris);
+        return false;
+    }
+
+    Vec4 *colours = malloc(sizeof(Vec4) * triangleCount);
+    MeshCullData cull;
+    if (!colours || !BuildMeshCullData(tris, triangleCount, &cull)) {
+        free(colours);
+        free(tris);
+        return false;
+    }
+    for (int i = 0; i < triangleCount; i++) colours[i] = TriangleColour(i);
+
+    // Same camera setup as main.c
+    Mat4 model = mat4_identity();
+    Mat4 proj = mat4_perspective(70.0f * (3.14159f / 180.0f), (float)TEST_WIDTH / TEST_HEIGHT, 0.1f, 100.0f);
+    Vec3 target = vec3_add(rc->cam.position, get_camera_forward(rc->cam));
+    Mat4 view = mat4_look_at(rc->cam.position, target, (Vec3){0, 1, 0});
+    Mat4 mvp = mat4_mul(proj, mat4_mul(view, model));
+
+    MsaaBuffer msaa;
+    if (rc->msaa && !MsaaInit(&msaa, TEST_WIDTH, TEST_HEIGHT)) {
+        FreeMeshCullData(&cull);
+        free(colours);
+        free(tris);
+        return false;
+    }
+
+    ShadowMap shadow = {0};
+    if (rc->shadows) {
+        if (!ShadowMapInit(&shadow, TEST_SHADOW_MAP_SIZE, true)) {
+            if (rc->msaa) MsaaDestroy(&msaa);
+            FreeMeshCullData(&cull);
+            free(colours);
+            free(tris);
+            return false;
+        }
+        ShadowMapFitScene(&shadow, (Vec3){0.35f, 1.0f, 0.5f}, tris, triangleCount);
+        RenderShadowMap(&shadow, tris, triangleCount);
+    }
+
+    RasterizeScene(TEST_HEIGHT, TEST_WIDTH, depth, model, tris, rc->cam.position, mvp, colours, &cull, pixels,
+            TEST_WIDTH, rc->msaa ? &msaa : NULL, rc->shadows ? &shadow : NULL);
+
+    if (rc->shadows) ShadowMapDestroy(&shadow);
+    if (rc->msaa) MsaaDestroy(&msaa);
+    FreeMeshCullData(&cull);
+    free(colours);
+    free(tris);
+    return true;
+}
+
+static bool DepthMatches(float a, float b, float tolerance) {
+    if (isinf(a) || isinf(b)) return a == b;
+    return fabsf(a - b) <= tolerance;
+}
+
+static int ChannelDiff(uint32_t a, uint32_t b) {
+    int maxDiff = 0;
+    for (int shift = 0; shift <= 16; shift += 8) {
+        int diff = abs((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF));
+        if (diff > maxDiff) maxDiff = diff;
+    }
+    return maxDiff;
+}
+
+static bool CompareCase(const RenderCase *rc, const char *goldenDir, const char *outDir,
+        const uint32_t *pixels, const float *depth, Tolerance tol) {
+    char colourPath[1024], depthPath[1024];
+    snprintf(colourPath, sizeof(colourPath), "%s/%s.ppm", goldenDir, rc->name);
+    snprintf(depthPath, sizeof(depthPath), "%s/%s.depth.pfm", goldenDir, rc->name);
+
+    int gw = 0, gh = 0, dw = 0, dh = 0;
+    uint32_t *goldenPixels = LoadPPM(colourPath, &gw, &gh);
+    float *goldenDepth = LoadPFM(depthPath, &dw, &dh);
+    if (!goldenPixels || !goldenDepth || gw != TEST_WIDTH || gh != TEST_HEIGHT
+        || dw != TEST_WIDTH || dh != TEST_HEIGHT) {
+        fprintf(stderr, "[%s] missing or mis-sized golden images in %s (run with -u to create)\n",
+                rc->name, goldenDir);
+        free(goldenPixels);
+        free(goldenDepth);
+        return false;
+    }
+
+    int totalPixels = TEST_WIDTH * TEST_HEIGHT;
+    uint32_t *diff = malloc(sizeof(uint32_t) * totalPixels);
+    if (!diff) {
+        free(goldenPixels);
+        free(goldenDepth);
+        return false;
+    }
+
+    // Mismatches are red, matches a dimmed copy of the render
+    int badColour = 0, badDepth = 0, worstChannel = 0;
+    float worstDepth = 0.0f;
+    for (int i = 0; i < totalPixels; i++) {
+        int channel = ChannelDiff(pixels[i], goldenPixels[i]);
+        bool depthOk = DepthMatches(depth[i], goldenDepth[i], tol.depthTolerance);
+        if (channel > worstChannel) worstChannel = channel;
+        if (!isinf(depth[i]) && !isinf(goldenDepth[i])) {
+            worstDepth = fmaxf(worstDepth, fabsf(depth[i] - goldenDepth[i]));
+        }
+
+        if (channel > tol.channelTolerance) badColour++;
+        if (!depthOk) badDepth++;
+
+        if (channel > tol.channelTolerance || !depthOk) {
+            diff[i] = 0xFFFF0000u;
+        } else {
+            diff[i] = (pixels[i] >> 2) & 0x003F3F3Fu;
+        }
+    }
+
+    int allowed = (int)(tol.maxBadFraction * totalPixels);
+    bool pass = badColour <= allowed && badDepth <= allowed;
+
+    printf("[%s] %s: colour %016llx depth %016llx, bad colour %d, bad depth %d (allowed %d), "
+           "max channel diff %d, max depth diff %g\n",
+           rc->name, pass ? "PASS" : "FAIL",
+           (unsigned long long)HashBytes(pixels, sizeof(uint32_t) * totalPixels),
+           (unsigned long long)HashBytes(depth, sizeof(float) * totalPixels),
+           badColour, badDepth, allowed, worstChannel, worstDepth);
+
+    if (!pass) {
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s.actual.ppm", outDir, rc->name);
+        WritePPM(path, pixels, TEST_WIDTH, TEST_HEIGHT, TEST_WIDTH);
+        snprintf(path, sizeof(path), "%s/%s.diff.ppm", outDir, rc->name);
+        WritePPM(path, diff, TEST_WIDTH, TEST_HEIGHT, TEST_WIDTH);
+        fprintf(stderr, "[%s] wrote actual and diff images to %s\n", rc->name, outDir);
+    }
+
+    free(diff);
+    free(goldenPixels);
+    free(goldenDepth);
+    return pass;
+}
+
+int main(int argc, char *argv[]) {
+    Tolerance tol = { 8, 0.002, 1e-4f };
+    bool update = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:p:z:u")) != -1) {
+        switch (opt) {
+            case 't': tol.channelTolerance = atoi(optarg); break;
+            case 'p': tol.maxBadFraction = atof(optarg); break;
+            case 'z': tol.depthTolerance = (float)atof(optarg); break;
+            case 'u': update = true; break;
+            default:
+                fprintf(stderr, "Usage: %s [-t channel_tol] [-p max_bad_fraction] [-z depth_tol] [-u] "
+                        "models_dir golden_dir output_dir\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (argc - optind != 3) {
+        fprintf(stderr, "Expected models_dir golden_dir output_dir\n");
+        return 1;
+    }
+    const char *modelsDir = argv[optind];
+    const char *goldenDir = argv[optind + 1];
+    const char *outDir = argv[optind + 2];
+
+    uint32_t *pixels = malloc(sizeof(uint32_t) * TEST_WIDTH * TEST_HEIGHT);
+    float *depth = malloc(sizeof(float) * TEST_WIDTH * TEST_HEIGHT);
+    if (!pixels || !depth) {
+        fprintf(stderr, "Failed to allocate framebuffers\n");
+        return 1;
+    }
+
+    int failures = 0;
+    int caseCount = (int)(sizeof(cases) / sizeof(cases[0]));
+    for (int c = 0; c < caseCount; c++) {
+        if (!RenderCaseBuffers(modelsDir, &cases[c], pixels, depth)) {
+            failures++;
+            continue;
+        }
+
+        if (update) {
+            char path[1024];
+            snprintf(path, sizeof(path), "%s/%s.ppm", goldenDir, cases[c].name);
+            bool ok = WritePPM(path, pixels, TEST_WIDTH, TEST_HEIGHT, TEST_WIDTH);
+            snprintf(path, sizeof(path), "%s/%s.depth.pfm", goldenDir, cases[c].name);
+            ok = WritePFM(path, depth, TEST_WIDTH, TEST_HEIGHT) && ok;
+            printf("[%s] %s golden images\n", cases[c].name, ok ? "updated" : "FAILED to write");
+            if (!ok) failures++;
+        } else if (!CompareCase(&cases[c], goldenDir, outDir, pixels, depth, tol)) {
+            failures++;
+        }
+    }
+
+    free(pixels);
+    free(depth);
+
+    printf("%d/%d cases passed\n", caseCount - failures, caseCount);
+    return failures == 0 ? 0 : 1;
+}